@@ -21,6 +21,7 @@
 #include <algorithm>
 #include <mutex>
 #include <map>
+#include <list>
 #include <unordered_map>
 #include <stdexcept>
 #include <cstdint>
@@ -15,7 +15,8 @@ void AstroWindow::Render()
             [&]()
             {
               mDiffrotData = DifferentialRotation::Calculate(mIPC, mDiffrotParameters.dataPath, mDiffrotParameters.xsize, mDiffrotParameters.ysize, mDiffrotParameters.idstep,
-                  mDiffrotParameters.idstride, ToRadians(mDiffrotParameters.thetamax), mDiffrotParameters.cadence, mDiffrotParameters.idstart, &mProgress);
+                  mDiffrotParameters.idstride, ToRadians(mDiffrotParameters.thetamax), mDiffrotParameters.cadence, mDiffrotParameters.idstart, &mProgress,
+                  mDiffrotParameters.twindow);
             });
 
       ImGui::SameLine();
@@ -49,6 +50,7 @@ void AstroWindow::Render()
       ImGui::SliderFloat("thetamax", &mDiffrotParameters.thetamax, 20, 80);
       ImGui::SliderInt("cadence", &mDiffrotParameters.cadence, 25, 100);
       ImGui::InputInt("id start", &mDiffrotParameters.idstart);
+      ImGui::SliderInt("time window", &mDiffrotParameters.twindow, 1, 25);
       ImGui::InputText("data path", &mDiffrotParameters.dataPath);
       ImGui::InputText("##load path", &mDiffrotParameters.loadPath);
       ImGui::SameLine();
@@ -63,7 +65,7 @@ void AstroWindow::Render()
             {
               DifferentialRotation::Optimize(mIPC, mDiffrotParameters.dataPath, mDiffrotParameters.xsize, mDiffrotParameters.ysize, mDiffrotParameters.idstep,
                   mDiffrotParameters.idstride, ToRadians(mDiffrotParameters.thetamax), mDiffrotParameters.cadence, mDiffrotParameters.idstart, mDiffrotParameters.xsizeopt,
-                  mDiffrotParameters.ysizeopt, mDiffrotParameters.popsize);
+                  mDiffrotParameters.ysizeopt, mDiffrotParameters.popsize, mDiffrotParameters.twindow);
             });
 
       ImGui::SliderInt("xsizeopt", &mDiffrotParameters.xsizeopt, 1, 500);
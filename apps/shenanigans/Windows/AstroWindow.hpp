@@ -14,6 +14,7 @@ class AstroWindow : public Window
     float thetamax = 50;
     int cadence = 45;
     int idstart = 18933122;
+    int twindow = 1;
     int xsizeopt = 1;
     int ysizeopt = 101;
     int popsize = 6;
@@ -23,7 +24,7 @@ class AstroWindow : public Window
 
   DiffrotParameters mDiffrotParameters;
   DifferentialRotation::DifferentialRotationData mDiffrotData{mDiffrotParameters.xsize, mDiffrotParameters.ysize, mDiffrotParameters.idstep, mDiffrotParameters.idstride,
-      mDiffrotParameters.thetamax, mDiffrotParameters.cadence, mDiffrotParameters.idstart};
+      mDiffrotParameters.thetamax, mDiffrotParameters.cadence, mDiffrotParameters.idstart, mDiffrotParameters.twindow};
   float mProgress = 0;
   SolarWindSpeedParameters mSwindParameters;
   IPC mIPC;
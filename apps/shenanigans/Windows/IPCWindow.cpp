@@ -41,6 +41,12 @@ void IPCWindow::Render()
       ImGui::SliderInt("InterpolationType", &mIPCParameters.IntT, 0, static_cast<int>(IPC::InterpolationType::InterpolationTypeCount) - 1,
           IPCParameters::InterpolationTypes[mIPCParameters.IntT]);
       ImGui::SliderInt("L1WindowType", &mIPCParameters.L1WinT, 0, static_cast<int>(IPC::L1WindowType::L1WindowTypeCount) - 1, IPCParameters::L1WindowTypes[mIPCParameters.L1WinT]);
+      ImGui::SliderInt("Precision", &mIPCParameters.Precision, 0, static_cast<int>(IPC::Precision::PrecisionCount) - 1, IPCParameters::Precisions[mIPCParameters.Precision]);
+      ImGui::Checkbox("HalfSpectrum", &mIPCParameters.HalfSpectrum);
+      ImGui::Checkbox("OptimalDFTSize", &mIPCParameters.OptimalDFTSize);
+      ImGui::Checkbox("RemoveMean", &mIPCParameters.RemoveMean);
+      ImGui::SliderInt("MaxShift", &mIPCParameters.MaxShift, 0, 64);
+      ImGui::SliderFloat("MinPeakQuality", &mIPCParameters.MinPeakQuality, 0, 50);
     }
 
     ImGui::SetNextItemOpen(true, ImGuiCond_Once);
@@ -121,6 +127,12 @@ void IPCWindow::UpdateIPCParameters(IPC& ipc)
   ipc.SetBandpassType(static_cast<IPC::BandpassType>(mIPCParameters.BPT));
   ipc.SetInterpolationType(static_cast<IPC::InterpolationType>(mIPCParameters.IntT));
   ipc.SetL1WindowType(static_cast<IPC::L1WindowType>(mIPCParameters.L1WinT));
+  ipc.SetPrecision(static_cast<IPC::Precision>(mIPCParameters.Precision));
+  ipc.SetHalfSpectrum(mIPCParameters.HalfSpectrum);
+  ipc.SetOptimalDFTSize(mIPCParameters.OptimalDFTSize);
+  ipc.SetRemoveMean(mIPCParameters.RemoveMean);
+  ipc.SetMaxShift(mIPCParameters.MaxShift);
+  ipc.SetMinPeakQuality(mIPCParameters.MinPeakQuality);
 }
 
 std::string IPCWindow::GetCurrentDatasetPath() const
@@ -19,10 +19,17 @@ class IPCWindow : public Window
     int BPT = static_cast<int>(IPC::BandpassType::None);
     int IntT = static_cast<int>(IPC::InterpolationType::Linear);
     int L1WinT = static_cast<int>(IPC::L1WindowType::None);
+    int Precision = static_cast<int>(IPC::Precision::Float64);
+    bool HalfSpectrum = false;
+    bool OptimalDFTSize = false;
+    bool RemoveMean = false;
+    int MaxShift = 0;
+    float MinPeakQuality = 0;
     static constexpr const char* WindowTypes[] = {"None", "Hann"};
     static constexpr const char* BandpassTypes[] = {"None", "Rectangular", "Gaussian"};
-    static constexpr const char* InterpolationTypes[] = {"NearestNeighbor", "Linear", "Cubic"};
+    static constexpr const char* InterpolationTypes[] = {"NearestNeighbor", "Linear", "Cubic", "DFTUpsample"};
     static constexpr const char* L1WindowTypes[] = {"None", "Circular", "Gaussian"};
+    static constexpr const char* Precisions[] = {"Float32", "Float64"};
   };
 
   struct IPCOptimizeParameters
@@ -1,5 +1,6 @@
 #pragma once
 #include "ImageRegistration/IPC.hpp"
+#include "ImageRegistration/IPCStatic.hpp"
 #include "Math/PolynomialFit.hpp"
 #include "Math/TrigonometricFit.hpp"
 #include "Utils/DataCache.hpp"
@@ -26,7 +27,7 @@ public:
   {
     DifferentialRotationData() {}
 
-    DifferentialRotationData(int xsize_, int ysize_, int idstep_, int idstride_, double thetamax_, int cadence_, int idstart_) :
+    DifferentialRotationData(int xsize_, int ysize_, int idstep_, int idstride_, double thetamax_, int cadence_, int idstart_, int twindow_ = 1) :
       xsize(xsize_),
       ysize(ysize_),
       idstep(idstep_),
@@ -34,6 +35,7 @@ public:
       thetamax(thetamax_),
       cadence(cadence_),
       idstart(idstart_),
+      twindow(twindow_),
       shiftx(cv::Mat::zeros(ysize_, xsize_, CV_32F)),
       shifty(cv::Mat::zeros(ysize_, xsize_, CV_32F)),
       omegax(cv::Mat::zeros(ysize_, xsize_, CV_32F)),
@@ -42,7 +44,8 @@ public:
       fshiftx(std::vector<double>(xsize_, 0.)),
       fshifty(std::vector<double>(xsize_, 0.)),
       theta0(std::vector<double>(xsize_, 0.)),
-      R(std::vector<double>(xsize_, 0.))
+      R(std::vector<double>(xsize_, 0.)),
+      pairs(std::vector<int>(xsize_, 0))
     {
     }
 
@@ -57,6 +60,8 @@ public:
       file["idstride"] >> idstride;
       file["thetamax"] >> thetamax;
       file["cadence"] >> cadence;
+      if (not file["twindow"].empty()) // not present in results saved before the time window option
+        file["twindow"] >> twindow;
       file["theta"] >> theta;
       file["shiftx"] >> shiftx;
       file["shifty"] >> shifty;
@@ -66,6 +71,8 @@ public:
       file["fshifty"] >> fshifty;
       file["theta0"] >> theta0;
       file["R"] >> R;
+      if (not file["pairs"].empty())
+        file["pairs"] >> pairs;
     }
 
     void Save(const std::string& dataPath, const IPC& ipc) const
@@ -81,6 +88,7 @@ public:
       file << "idstride" << idstride;
       file << "thetamax" << thetamax;
       file << "cadence" << cadence;
+      file << "twindow" << twindow;
       file << "IPC" << ipc.Serialize();
       file << "theta" << theta;
       file << "shiftx" << shiftx;
@@ -91,6 +99,7 @@ public:
       file << "fshifty" << fshifty;
       file << "theta0" << theta0;
       file << "R" << R;
+      file << "pairs" << pairs;
     }
 
     static std::vector<double> GenerateTheta(int ysize, double thetamax)
@@ -169,15 +178,17 @@ public:
     double thetamax = ToRadians(50);
     int cadence = 45;
     int idstart = 123456;
+    int twindow = 1; // number of consecutive image pairs accumulated into each measurement
 
     cv::Mat shiftx, shifty, omegax, omegay;
     std::vector<double> theta, fshiftx, fshifty, theta0, R;
+    std::vector<int> pairs; // number of image pairs accumulated into each measurement (0 for skipped / interpolated measurements)
   };
 
   template <bool Managed = false> // executed automatically by some logic (e.g.
                                   // optimization algorithm) instead of manually
-  static DifferentialRotationData Calculate(
-      const IPC& ipc, const std::string& dataPath, int xsize, int ysize, int idstep, int idstride, double thetamax, int cadence, int idstart, float* progress = nullptr)
+  static DifferentialRotationData Calculate(const IPC& ipc, const std::string& dataPath, int xsize, int ysize, int idstep, int idstride, double thetamax, int cadence, int idstart,
+      float* progress = nullptr, int twindow = 1)
   {
     PROFILE_FUNCTION;
     if constexpr (not Managed)
@@ -190,20 +201,24 @@ public:
         }};
     DataCache<std::string, ImageHeader> headerCache{[](const std::string& path) { return GetHeader(path); }};
 
-    return Calculate<Managed>(ipc, dataPath, xsize, ysize, idstep, idstride, thetamax, cadence, idstart, progress, imageCache, headerCache);
+    return Calculate<Managed>(ipc, dataPath, xsize, ysize, idstep, idstride, thetamax, cadence, idstart, progress, imageCache, headerCache, twindow);
   }
 
   template <bool Managed = false> // executed automatically by some logic (e.g.
                                   // optimization algorithm) instead of manually
   static DifferentialRotationData Calculate(const IPC& ipc, const std::string& dataPath, int xsize, int ysize, int idstep, int idstride, double thetamax, int cadence, int idstart,
-      float* progress, DataCache<std::string, cv::Mat>& imageCache, DataCache<std::string, ImageHeader>& headerCache)
+      float* progress, DataCache<std::string, cv::Mat>& imageCache, DataCache<std::string, ImageHeader>& headerCache, int twindow = 1)
   {
     PROFILE_FUNCTION;
     if constexpr (not Managed)
       LOG_FUNCTION;
 
-    DifferentialRotationData data(xsize, ysize, idstep, idstride, thetamax, cadence, idstart);
+    if (twindow < 1) [[unlikely]]
+      throw std::invalid_argument(fmt::format("Invalid time window ({} < 1)", twindow));
+
+    DifferentialRotationData data(xsize, ysize, idstep, idstride, thetamax, cadence, idstart, twindow);
     std::atomic<int> progressi = 0;
+    std::atomic<int> skippedPairs = 0;
     const auto tstep = idstep * cadence;
     const auto wxsize = ipc.GetCols();
     const auto wysize = ipc.GetRows();
@@ -213,6 +228,7 @@ public:
     const auto fshiftmax = 0.1;
     const auto ids = data.GenerateIds();
     const auto omegaxpred = GetPredictedOmegas(data.theta, 14.296, -1.847, -2.615);
+    const auto engine = CreateIPCEngine(ipc);
 
 #pragma omp parallel for if (not Managed)
     for (int x = 0; x < xsize; ++x)
@@ -245,29 +261,84 @@ public:
         const auto image2 = imageCache.Get(path2);
         const auto header1 = headerCache.Get(fmt::format("{}/{}.json", dataPath, id1));
         const auto header2 = headerCache.Get(fmt::format("{}/{}.json", dataPath, id2));
-        const auto theta0 = (header1.theta0 + header2.theta0) / 2;
-        const auto R = (header1.R + header2.R) / 2;
         const auto xindex = xsize - 1 - x;
         data.fshiftx[xindex] = header2.xcenter - header1.xcenter;
         data.fshifty[xindex] = header2.ycenter - header1.ycenter;
-        data.theta0[xindex] = theta0;
-        data.R[xindex] = R;
+        data.theta0[xindex] = (header1.theta0 + header2.theta0) / 2;
+        data.R[xindex] = (header1.R + header2.R) / 2;
 
         if (std::abs(data.fshiftx[xindex]) > fshiftmax or std::abs(data.fshifty[xindex]) > fshiftmax) [[unlikely]]
           continue;
 
+        // crops of all image pairs of the time window per latitude row, each pair is cropped with its own disk geometry
+        std::vector<std::vector<cv::Mat>> crops1(ysize), crops2(ysize);
+        std::vector<double> pairRs;
+        double sumTheta0 = 0;
+        const auto addCrops = [&](const cv::Mat& pairImage1, const cv::Mat& pairImage2, const ImageHeader& pairHeader1, const ImageHeader& pairHeader2)
+        {
+          const auto pairTheta0 = (pairHeader1.theta0 + pairHeader2.theta0) / 2;
+          const auto pairR = (pairHeader1.R + pairHeader2.R) / 2;
+          pairRs.push_back(pairR);
+          sumTheta0 += pairTheta0;
+          for (int y = 0; y < ysize; ++y)
+          {
+            const auto yshift = -pairR * std::sin(data.theta[y] - pairTheta0);
+            crops1[y].push_back(RoiCropRef(pairImage1, std::round(pairHeader1.xcenter), std::round(pairHeader1.ycenter + yshift), wxsize, wysize));
+            crops2[y].push_back(RoiCropRef(pairImage2, std::round(pairHeader2.xcenter), std::round(pairHeader2.ycenter + yshift), wxsize, wysize));
+          }
+        };
+        addCrops(image1, image2, header1, header2);
+
+        // the following consecutive image pairs of the time window are accumulated into the same latitude measurements, pairs with missing data are left out
+        for (int pair = 1; pair < twindow; ++pair)
+        {
+          const auto pairid1 = id1 + pair * idstep;
+          const auto pairid2 = id2 + pair * idstep;
+          const auto pairpath1 = fmt::format("{}/{}.png", dataPath, pairid1);
+          const auto pairpath2 = fmt::format("{}/{}.png", dataPath, pairid2);
+          if (not std::filesystem::exists(pairpath1) or not std::filesystem::exists(pairpath2)) [[unlikely]]
+            continue;
+
+          const auto pairHeader1 = headerCache.Get(fmt::format("{}/{}.json", dataPath, pairid1));
+          const auto pairHeader2 = headerCache.Get(fmt::format("{}/{}.json", dataPath, pairid2));
+          if (std::abs(pairHeader2.xcenter - pairHeader1.xcenter) > fshiftmax or std::abs(pairHeader2.ycenter - pairHeader1.ycenter) > fshiftmax) [[unlikely]]
+            continue;
+
+          addCrops(imageCache.Get(pairpath1), imageCache.Get(pairpath2), pairHeader1, pairHeader2);
+        }
+
+        const int pairs = pairRs.size();
+        if (pairs < twindow)
+        {
+          skippedPairs += twindow - pairs;
+          if constexpr (not Managed)
+            LOG_DEBUG("Measurement {} - {} accumulated {} / {} image pairs", id1, id2, pairs, twindow);
+        }
+
+        // the normalized cross-power spectra of the time window are summed per latitude, so only one inverse DFT and refinement is needed per latitude
+        const auto shifts = engine->CalculateAccumulatedBatch(crops1, crops2);
+        data.theta0[xindex] = sumTheta0 / pairs;
+        data.R[xindex] = std::accumulate(pairRs.begin(), pairRs.end(), 0.) / pairs;
+        data.pairs[xindex] = pairs;
+
         for (int y = 0; y < ysize; ++y)
         {
           PROFILE_SCOPE(CalculateMeridianShift);
           const auto theta = data.theta[y];
-          const auto yshift = -R * std::sin(theta - theta0);
-          auto crop1 = RoiCrop(image1, std::round(header1.xcenter), std::round(header1.ycenter + yshift), wxsize, wysize);
-          auto crop2 = RoiCrop(image2, std::round(header2.xcenter), std::round(header2.ycenter + yshift), wxsize, wysize);
-          const auto shift = ipc.Calculate(std::move(crop1), std::move(crop2));
+          const auto& shift = shifts[y];
           const auto shiftx = std::clamp(shift.x, shiftxmin, shiftxmax);
           const auto shifty = std::clamp(shift.y, -shiftymax, shiftymax);
-          const auto omegax = std::clamp(std::asin(shiftx / (R * std::cos(theta))) / tstep * RadPerSecToDegPerDay, 0.7 * omegaxpred[y], 1.3 * omegaxpred[y]);
-          const auto omegay = (std::asin((R * std::sin(theta) + shifty) / R) - theta) / tstep * RadPerSecToDegPerDay;
+
+          // the summed shift is the common shift of the accumulated pairs, it is converted to angular velocities with the disk radius of each pair and
+          // averaged (all pairs span the same time step idstep * cadence)
+          double omegaxsum = 0, omegaysum = 0;
+          for (const auto R : pairRs)
+          {
+            omegaxsum += std::asin(shiftx / (R * std::cos(theta))) / tstep * RadPerSecToDegPerDay;
+            omegaysum += (std::asin((R * std::sin(theta) + shifty) / R) - theta) / tstep * RadPerSecToDegPerDay;
+          }
+          const auto omegax = std::clamp(omegaxsum / pairs, 0.7 * omegaxpred[y], 1.3 * omegaxpred[y]);
+          const auto omegay = omegaysum / pairs;
 
           data.shiftx.at<float>(y, xindex) = shiftx;
           data.shifty.at<float>(y, xindex) = shifty;
@@ -282,6 +353,10 @@ public:
         continue;
       }
 
+    if constexpr (not Managed)
+      if (skippedPairs > 0)
+        LOG_WARNING("{} image pairs of the time windows were skipped (missing images or disk center shifts)", skippedPairs.load());
+
     data.FixMissingData<Managed>();
     data.PostProcess();
 
@@ -295,8 +370,8 @@ public:
     return data;
   }
 
-  static void Optimize(
-      IPC& ipc, const std::string& dataPath, int xsize, int ysize, int idstep, int idstride, double thetamax, int cadence, int idstart, int xsizeopt, int ysizeopt, int popsize)
+  static void Optimize(IPC& ipc, const std::string& dataPath, int xsize, int ysize, int idstep, int idstride, double thetamax, int cadence, int idstart, int xsizeopt,
+      int ysizeopt, int popsize, int twindow = 1)
   {
     PROFILE_FUNCTION;
     LOG_FUNCTION;
@@ -306,7 +381,7 @@ public:
     LOG_INFO("Optimization ysize: {}", ysizeopt);
     LOG_INFO("Optimization popsize: {}", popsize);
     LOG_INFO("Optimization idstride: {}", idstrideopt);
-    const size_t ids = idstride > 0 ? xsizeopt * 2 : xsizeopt + 1;
+    const size_t ids = (idstride > 0 ? xsizeopt * 2 : xsizeopt + 1) * twindow;
     DataCache<std::string, cv::Mat> imageCache{[](const std::string& path)
         {
           PROFILE_SCOPE(Imread);
@@ -316,12 +391,12 @@ public:
     imageCache.Reserve(ids);
     headerCache.Reserve(ids);
 
-    const auto dataBefore = Calculate<true>(ipc, dataPath, xsizeopt, ysizeopt, idstep, idstride, thetamax, cadence, idstart, nullptr, imageCache, headerCache);
+    const auto dataBefore = Calculate<true>(ipc, dataPath, xsizeopt, ysizeopt, idstep, idstride, thetamax, cadence, idstart, nullptr, imageCache, headerCache, twindow);
     const auto predfit = GetVectorAverage({GetPredictedOmegas(dataBefore.theta, 14.296, -1.847, -2.615), GetPredictedOmegas(dataBefore.theta, 14.192, -1.70, -2.36)});
 
     const auto obj = [&](const IPC& ipcopt)
     {
-      const auto dataopt = Calculate<true>(ipc, dataPath, xsizeopt, ysizeopt, idstep, idstride, thetamax, cadence, idstart, nullptr, imageCache, headerCache);
+      const auto dataopt = Calculate<true>(ipc, dataPath, xsizeopt, ysizeopt, idstep, idstride, thetamax, cadence, idstart, nullptr, imageCache, headerCache, twindow);
       if (dataopt.omegax.empty())
         return std::numeric_limits<double>::infinity();
       const auto omegax = GetRowAverage(dataopt.omegax);
@@ -339,7 +414,7 @@ public:
     IPCOptimization::Optimize(ipc, obj, popsize);
     if (xsizeopt >= 100)
       SaveOptimizedParameters(ipc, fmt::format("{}/proc", dataPath), xsizeopt, ysizeopt, popsize);
-    const auto dataAfter = Calculate<true>(ipc, dataPath, xsizeopt, ysizeopt, idstep, idstride, thetamax, cadence, idstart, nullptr, imageCache, headerCache);
+    const auto dataAfter = Calculate<true>(ipc, dataPath, xsizeopt, ysizeopt, idstep, idstride, thetamax, cadence, idstart, nullptr, imageCache, headerCache, twindow);
 
     Plot::Plot({
         .name = "Diffrot opt",
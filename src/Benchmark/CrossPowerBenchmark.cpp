@@ -0,0 +1,38 @@
+#include <benchmark/benchmark.h>
+#include "Math/CrossPower.hpp"
+#include "Math/Functions.hpp"
+
+// normalized & bandpass-filtered cross-power spectrum of two size x size spectra, range(0) = SimdLevel, range(1) = size
+template <typename T>
+static void CrossPowerSpectrumBenchmark(benchmark::State& state)
+{
+  const auto level = static_cast<SimdLevel>(state.range(0));
+  const auto size = static_cast<int>(state.range(1));
+  if (level > GetSimdLevel())
+  {
+    state.SkipWithError("Instruction set not supported by this cpu");
+    return;
+  }
+
+  cv::Mat dft1(size, size, GetMatType<T>(2));
+  cv::Mat dft2(size, size, GetMatType<T>(2));
+  cv::Mat band(size, size, GetMatType<T>());
+  cv::Mat out(size, size, GetMatType<T>(2));
+  cv::randu(dft1, cv::Scalar::all(-1), cv::Scalar::all(1));
+  cv::randu(dft2, cv::Scalar::all(-1), cv::Scalar::all(1));
+  cv::randu(band, cv::Scalar::all(0), cv::Scalar::all(1));
+
+  for (auto _ : state)
+  {
+    for (int row = 0; row < size; ++row)
+      CrossPowerSpectrum<T>(dft1.ptr<T>(row), dft2.ptr<T>(row), out.ptr<T>(row), band.ptr<T>(row), size, 1e-6, true, level);
+    benchmark::ClobberMemory();
+  }
+
+  state.SetItemsProcessed(state.iterations() * size * size);
+  state.SetBytesProcessed(state.iterations() * size * size * 5 * sizeof(T));
+  state.SetLabel(std::string(SimdLevel2String(level)));
+}
+
+BENCHMARK_TEMPLATE(CrossPowerSpectrumBenchmark, float)->ArgsProduct({{0, 1, 2}, {256, 1024}});
+BENCHMARK_TEMPLATE(CrossPowerSpectrumBenchmark, double)->ArgsProduct({{0, 1, 2}, {256, 1024}});
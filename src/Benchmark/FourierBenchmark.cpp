@@ -0,0 +1,34 @@
+#include <benchmark/benchmark.h>
+#include "Math/Fourier.hpp"
+
+// forward (full / packed) and inverse DFT of a size x size image, range(0) = FFTBackend, range(1) = size, range(2) = packed
+template <typename T>
+static void FFTBenchmark(benchmark::State& state)
+{
+  const auto backend = static_cast<FFTBackend>(state.range(0));
+  const auto size = static_cast<int>(state.range(1));
+  const bool packed = state.range(2);
+  if (not IsFFTBackendAvailable(backend))
+  {
+    state.SkipWithError("FFT backend not available in this build");
+    return;
+  }
+
+  const auto& engine = GetFFTEngine(backend);
+  cv::Mat img(size, size, GetMatType<T>());
+  cv::randu(img, cv::Scalar::all(0), cv::Scalar::all(1));
+  cv::Mat spectrum, result;
+
+  for (auto _ : state)
+  {
+    engine.Forward(img, spectrum, packed);
+    engine.Inverse(spectrum, result);
+    benchmark::DoNotOptimize(result.data);
+  }
+
+  state.SetItemsProcessed(state.iterations() * size * size);
+  state.SetLabel(FFTBackend2String(backend) + (packed ? " packed" : " full"));
+}
+
+BENCHMARK_TEMPLATE(FFTBenchmark, float)->ArgsProduct({{0, 1}, {256, 1000, 1024}, {0, 1}});
+BENCHMARK_TEMPLATE(FFTBenchmark, double)->ArgsProduct({{0, 1}, {256, 1000, 1024}, {0, 1}});
@@ -0,0 +1,275 @@
+#include <benchmark/benchmark.h>
+#include "ImageRegistration/IPC.hpp"
+#include "ImageRegistration/IPCFlow.hpp"
+#include "ImageRegistration/IPCPyramid.hpp"
+#include "ImageRegistration/IPCStatic.hpp"
+#include "Math/Transform.hpp"
+
+// random image pair of the given size, image2 is image1 shifted by shift
+static std::pair<cv::Mat, cv::Mat> CreateImagePair(const cv::Size& size, const cv::Point2d& shift = cv::Point2d(3.3, -2.7))
+{
+  cv::Mat image1(size, CV_32F);
+  cv::randu(image1, cv::Scalar(0), cv::Scalar(1));
+  cv::Mat image2 = image1.clone();
+  Shift(image2, shift);
+  return {image1, image2};
+}
+
+// IPC latency across window sizes (including sizes with large prime factors), range(0) = size, range(1) = optimal DFT size padding
+static void IPCOptimalDFTSizeBenchmark(benchmark::State& state)
+{
+  const auto size = static_cast<int>(state.range(0));
+  IPC ipc(size, size);
+  ipc.SetOptimalDFTSize(state.range(1));
+
+  const auto [image1, image2] = CreateImagePair(cv::Size(size, size));
+
+  for (auto _ : state)
+    benchmark::DoNotOptimize(ipc.Calculate(image1, image2));
+
+  state.SetLabel(fmt::format("dft {}x{}", ipc.GetDFTSize().width, ipc.GetDFTSize().height));
+}
+
+BENCHMARK(IPCOptimalDFTSizeBenchmark)->ArgsProduct({{127, 128, 251, 256, 257, 331, 509, 512, 521, 727, 1021, 1024}, {0, 1}})->Unit(benchmark::kMicrosecond);
+
+// IPC construction with optimizer-like parameter setting, range(0) = size, range(1) = mask cache hits (the cache is cleared every iteration otherwise)
+static void IPCConstructionBenchmark(benchmark::State& state)
+{
+  const auto size = static_cast<int>(state.range(0));
+  const bool cached = state.range(1);
+  for (auto _ : state)
+  {
+    if (not cached)
+      IPCMaskCache::Clear();
+
+    IPC ipc(size, size);
+    ipc.SetBandpassType(IPC::BandpassType::Gaussian);
+    ipc.SetBandpassParameters(0.1, 0.9);
+    ipc.SetWindowType(IPC::WindowType::Hann);
+    ipc.SetL1WindowType(IPC::L1WindowType::Circular);
+    ipc.SetL2Usize(357);
+    ipc.SetL1ratio(0.35);
+    benchmark::DoNotOptimize(ipc.GetBandpass().data);
+  }
+}
+
+BENCHMARK(IPCConstructionBenchmark)->ArgsProduct({{128, 512, 1024}, {0, 1}})->Unit(benchmark::kMicrosecond);
+
+// IPC latency with the plausible-shift L3 sub-grid, range(0) = size, range(1) = maximum shift (0 = full inverse DFT)
+static void IPCMaxShiftBenchmark(benchmark::State& state)
+{
+  const auto size = static_cast<int>(state.range(0));
+  IPC ipc(size, size);
+  ipc.SetMaxShift(state.range(1));
+
+  const auto [image1, image2] = CreateImagePair(cv::Size(size, size));
+
+  for (auto _ : state)
+    benchmark::DoNotOptimize(ipc.Calculate(image1, image2));
+}
+
+BENCHMARK(IPCMaxShiftBenchmark)->ArgsProduct({{256, 512, 1024}, {0, 4, 8, 16}})->Unit(benchmark::kMicrosecond);
+
+// IPC latency for input images of different depths preprocessed straight from the source pixels, range(0) = size, range(1) = depth, range(2) = mean removal
+static void IPCInputDepthBenchmark(benchmark::State& state)
+{
+  const auto size = static_cast<int>(state.range(0));
+  const auto depth = static_cast<int>(state.range(1));
+  IPC ipc(size, size);
+  ipc.SetRemoveMean(state.range(2));
+
+  cv::Mat image(size + 16, size + 16, CV_32F);
+  cv::randu(image, cv::Scalar(0), cv::Scalar(1));
+  image.convertTo(image, depth, depth == CV_8U ? 255 : depth == CV_16U ? 65535 : 1);
+  const cv::Mat image1 = image(cv::Rect(0, 0, size, size)); // non-continuous ROI views
+  const cv::Mat image2 = image(cv::Rect(3, 5, size, size));
+
+  for (auto _ : state)
+    benchmark::DoNotOptimize(ipc.Calculate(image1, image2));
+}
+
+BENCHMARK(IPCInputDepthBenchmark)->ArgsProduct({{256, 512, 1024}, {CV_8U, CV_16U, CV_32F}, {0, 1}})->Unit(benchmark::kMicrosecond);
+
+// L2U upsampling by the cubic L2 interpolation vs the band-limited DFT evaluation, range(0) = size, range(1) = DFT upsampling, range(2) = half spectrum
+static void IPCDFTUpsampleBenchmark(benchmark::State& state)
+{
+  const auto size = static_cast<int>(state.range(0));
+  IPC ipc(size, size);
+  ipc.SetInterpolationType(state.range(1) ? IPC::InterpolationType::DFTUpsample : IPC::InterpolationType::Cubic);
+  ipc.SetHalfSpectrum(state.range(2));
+
+  const auto [image1, image2] = CreateImagePair(cv::Size(size, size));
+
+  for (auto _ : state)
+    benchmark::DoNotOptimize(ipc.Calculate(image1, image2));
+}
+
+BENCHMARK(IPCDFTUpsampleBenchmark)->ArgsProduct({{256, 512, 1024}, {0, 1}, {0, 1}})->Unit(benchmark::kMicrosecond);
+
+// L1 centroid evaluation, range(0) = L1 window type (none / circular use the L2U summed-area tables, gaussian the windowed L1 moments), range(1) =
+// L2U size
+static void IPCL1WindowBenchmark(benchmark::State& state)
+{
+  IPC ipc(256, 256);
+  ipc.SetL1WindowType(static_cast<IPC::L1WindowType>(state.range(0)));
+  ipc.SetL2Usize(state.range(1));
+
+  const auto [image1, image2] = CreateImagePair(cv::Size(256, 256));
+
+  for (auto _ : state)
+    benchmark::DoNotOptimize(ipc.Calculate(image1, image2));
+  state.SetLabel(IPC::L1WindowType2String(ipc.GetL1WindowType()));
+}
+
+BENCHMARK(IPCL1WindowBenchmark)->ArgsProduct({{0, 1, 2}, {101, 223, 357}})->Unit(benchmark::kMicrosecond);
+
+// runtime configured IPC vs the precompiled static specialization of the default configuration, range(0) = size, range(1) = static specialization
+static void IPCStaticBenchmark(benchmark::State& state)
+{
+  const auto size = static_cast<int>(state.range(0));
+  const IPC ipc(size, size);
+  const auto engine = CreateIPCEngine(ipc);
+
+  const auto [image1, image2] = CreateImagePair(cv::Size(size, size));
+
+  for (auto _ : state)
+    benchmark::DoNotOptimize(state.range(1) ? engine->Calculate(image1, image2) : ipc.Calculate(image1, image2));
+}
+
+BENCHMARK(IPCStaticBenchmark)->ArgsProduct({{64, 128, 256, 512}, {0, 1}})->Unit(benchmark::kMicrosecond);
+
+// full size IPC vs the coarse-to-fine pyramid IPC with a half size refinement window, range(0) = size, range(1) = pyramid levels (0 = full size IPC)
+static void IPCPyramidBenchmark(benchmark::State& state)
+{
+  const auto size = static_cast<int>(state.range(0));
+  const int levels = state.range(1);
+  const IPC ipc(size, size);
+  const auto pyramid = levels > 0 ? std::make_optional<IPCPyramid>(ipc, levels, size / 2) : std::nullopt;
+
+  const cv::Point2d shift(0.05 * size + 0.3, -0.03 * size - 0.7);
+  const auto [image1, image2] = CreateImagePair(cv::Size(size, size), shift);
+
+  cv::Point2d result;
+  for (auto _ : state)
+    benchmark::DoNotOptimize(result = pyramid ? pyramid->Calculate(image1, image2) : ipc.Calculate(image1, image2));
+
+  state.SetLabel(fmt::format("error {:.3f} px", Magnitude(result - shift)));
+}
+
+BENCHMARK(IPCPyramidBenchmark)->ArgsProduct({{1024, 2048, 4096}, {0, 1, 2, 3}})->Unit(benchmark::kMillisecond);
+
+// dense IPC flow of a 512x512 image pair, range(0) = window size, range(1) = flow pixels per image pixel [%], range(2) = window spectra (0 = per window,
+// 1 = shared)
+static void IPCFlowBenchmark(benchmark::State& state)
+{
+  const auto size = static_cast<int>(state.range(0));
+  const double resolution = state.range(1) / 100.;
+  const auto spectra = static_cast<IPCFlow::Spectra>(state.range(2));
+  const IPC ipc(size, size);
+
+  const auto [image1, image2] = CreateImagePair(cv::Size(512, 512), cv::Point2d(1.3, -0.7));
+
+  for (auto _ : state)
+    benchmark::DoNotOptimize(IPCFlow::CalculateFlow(ipc, image1, image2, resolution, spectra));
+}
+
+BENCHMARK(IPCFlowBenchmark)->ArgsProduct({{32, 64, 128}, {10, 25}, {0, 1}})->Unit(benchmark::kMillisecond);
+
+// single level dense IPC flow with windows large enough for the motion vs the pyramid flow with small windows, range(0) = pyramid levels (0 = single
+// level flow with 64x64 windows, 16x16 windows otherwise), the label shows the mean endpoint error of the interior flow
+static void IPCFlowPyramidBenchmark(benchmark::State& state)
+{
+  const int levels = state.range(0);
+  const IPC ipc(levels > 0 ? 16 : 64);
+  const double resolution = 0.25;
+  const cv::Point2d shift(9.4, -6.8);
+
+  const auto [image1, image2] = CreateImagePair(cv::Size(512, 512), shift);
+
+  cv::Mat flowX, flowY;
+  for (auto _ : state)
+    std::tie(flowX, flowY) = levels > 0 ? IPCFlow::CalculateFlowPyramid(ipc, image1, image2, resolution, levels) : IPCFlow::CalculateFlow(ipc, image1, image2, resolution);
+
+  // endpoint error of the flow pixels whose windows are inside the images for all compared configurations
+  const cv::Rect interior(flowX.cols / 4, flowX.rows / 4, flowX.cols / 2, flowX.rows / 2);
+  cv::Mat errorX = flowX(interior) - shift.x, errorY = flowY(interior) - shift.y, error;
+  cv::magnitude(errorX, errorY, error);
+  state.SetLabel(fmt::format("endpoint error {:.3f} px", cv::mean(error)[0]));
+}
+
+BENCHMARK(IPCFlowPyramidBenchmark)->DenseRange(0, 3)->Unit(benchmark::kMillisecond);
+
+// single pass dense IPC flow vs the tiled flow, range(0) = flow tile size (0 = CalculateFlow), range(1) = window spectra (0 = per window, 1 = shared)
+static void IPCFlowTiledBenchmark(benchmark::State& state)
+{
+  const auto tileSize = static_cast<int>(state.range(0));
+  const auto spectra = static_cast<IPCFlow::Spectra>(state.range(1));
+  const IPC ipc(64, 64);
+  const double resolution = 0.1;
+
+  const auto [image1, image2] = CreateImagePair(cv::Size(2048, 2048), cv::Point2d(1.3, -0.7));
+
+  cv::Mat flowX, flowY;
+  for (auto _ : state)
+  {
+    if (tileSize > 0)
+      IPCFlow::CalculateFlowTiled(ipc, image1, image2, resolution, flowX, flowY, tileSize, spectra);
+    else
+      std::tie(flowX, flowY) = IPCFlow::CalculateFlow(ipc, image1, image2, resolution, spectra);
+  }
+}
+
+BENCHMARK(IPCFlowTiledBenchmark)->ArgsProduct({{0, 16, 64, 256}, {0, 1}})->Unit(benchmark::kMillisecond);
+
+// dense IPC flow of a frame sequence, range(0) = 0 for separate CalculateFlow calls of the consecutive pairs, 1 for the sequence flow which transforms
+// every frame once, range(1) = window spectra (0 = per window, 1 = shared)
+static void IPCFlowSequenceBenchmark(benchmark::State& state)
+{
+  const bool sequence = state.range(0);
+  const auto spectra = static_cast<IPCFlow::Spectra>(state.range(1));
+  const IPC ipc(32, 32);
+  const double resolution = 0.25;
+
+  std::vector<cv::Mat> frames(8);
+  frames[0].create(512, 512, CV_32F);
+  cv::randu(frames[0], cv::Scalar(0), cv::Scalar(1));
+  for (size_t i = 1; i < frames.size(); ++i)
+  {
+    frames[i] = frames[i - 1].clone();
+    Shift(frames[i], cv::Point2d(1.3, -0.7));
+  }
+
+  for (auto _ : state)
+  {
+    if (sequence)
+      benchmark::DoNotOptimize(IPCFlow::CalculateFlowSequence(ipc, frames, resolution, spectra));
+    else
+      for (size_t pair = 0; pair + 1 < frames.size(); ++pair)
+        benchmark::DoNotOptimize(IPCFlow::CalculateFlow(ipc, frames[pair], frames[pair + 1], resolution, spectra));
+  }
+}
+
+BENCHMARK(IPCFlowSequenceBenchmark)->ArgsProduct({{0, 1}, {0, 1}})->Unit(benchmark::kMillisecond);
+
+// dense IPC flow vs the adaptive sparse flow, range(0) = coarse grid step (0 = CalculateFlow), the label shows the mean endpoint error of the interior
+// flow
+static void IPCFlowAdaptiveBenchmark(benchmark::State& state)
+{
+  const auto step = static_cast<int>(state.range(0));
+  const IPC ipc(32, 32);
+  const double resolution = 0.25;
+  const cv::Point2d shift(1.3, -0.7);
+
+  const auto [image1, image2] = CreateImagePair(cv::Size(512, 512), shift);
+
+  cv::Mat flowX, flowY;
+  for (auto _ : state)
+    std::tie(flowX, flowY) = step > 0 ? IPCFlow::CalculateFlowAdaptive(ipc, image1, image2, resolution, step) : IPCFlow::CalculateFlow(ipc, image1, image2, resolution);
+
+  const cv::Rect interior(flowX.cols / 4, flowX.rows / 4, flowX.cols / 2, flowX.rows / 2);
+  cv::Mat errorX = flowX(interior) - shift.x, errorY = flowY(interior) - shift.y, error;
+  cv::magnitude(errorX, errorY, error);
+  state.SetLabel(fmt::format("endpoint error {:.3f} px", cv::mean(error)[0]));
+}
+
+BENCHMARK(IPCFlowAdaptiveBenchmark)->Arg(0)->Arg(4)->Arg(8)->Arg(16)->Unit(benchmark::kMillisecond);
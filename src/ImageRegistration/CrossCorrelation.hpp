@@ -1,6 +1,7 @@
 #pragma once
 #include "Math/Fourier.hpp"
 #include "Math/Functions.hpp"
+#include "Math/CrossPower.hpp"
 
 class CrossCorrelation
 {
@@ -58,19 +59,7 @@ private:
   static cv::Mat CalculateCrossPowerSpectrum(cv::Mat&& dft1, cv::Mat&& dft2)
   {
     PROFILE_FUNCTION;
-    for (int row = 0; row < dft1.rows; ++row)
-    {
-      auto dft1p = dft1.ptr<cv::Vec<Float, 2>>(row); // reuse dft1 memory
-      const auto dft2p = dft2.ptr<cv::Vec<Float, 2>>(row);
-      for (int col = 0; col < dft1.cols; ++col)
-      {
-        const Float re = dft1p[col][0] * dft2p[col][0] + dft1p[col][1] * dft2p[col][1];
-        const Float im = dft1p[col][0] * dft2p[col][1] - dft1p[col][1] * dft2p[col][0];
-
-        dft1p[col][0] = re;
-        dft1p[col][1] = im;
-      }
-    }
+    CrossPowerSpectrum<Float>(dft1, dft2, dft1, cv::Mat(), 0, false); // reuse dft1 memory
     return dft1;
   }
 
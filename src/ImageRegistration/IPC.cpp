@@ -1,5 +1,6 @@
 #include "IPC.hpp"
 #include "Plot/Plot.hpp"
+#include "Utils/ParallelFor.hpp"
 
 std::string IPC::BandpassType2String(BandpassType type)
 {
@@ -54,26 +55,58 @@ std::string IPC::InterpolationType2String(InterpolationType type)
     return "Linear";
   case InterpolationType::Cubic:
     return "Cubic";
+  case InterpolationType::DFTUpsample:
+    return "DFT";
   default:
     return "Unknown";
   }
 }
 
+std::string IPC::Precision2String(Precision precision)
+{
+  switch (precision)
+  {
+  case Precision::Float32:
+    return "Float32";
+  case Precision::Float64:
+    return "Float64";
+  default:
+    return "Unknown";
+  }
+}
+
+std::vector<cv::Point2d> IPC::CalculateBatch(std::span<const cv::Mat> images1, std::span<const cv::Mat> images2) const
+{
+  PROFILE_FUNCTION;
+  return ParallelForPairs(images1, images2, [this](const cv::Mat& image1, const cv::Mat& image2) { return Calculate(image1, image2); });
+}
+
+std::vector<cv::Point2d> IPC::CalculateAccumulatedBatch(std::span<const std::vector<cv::Mat>> images1, std::span<const std::vector<cv::Mat>> images2) const
+{
+  PROFILE_FUNCTION;
+  return ParallelForPairs(images1, images2, [this](const std::vector<cv::Mat>& group1, const std::vector<cv::Mat>& group2) { return CalculateAccumulated(group1, group2); });
+}
+
 // cppcheck-suppress unusedFunction
 std::string IPC::Serialize() const
 {
-  return fmt::format("Rows: {}, Cols: {}, BPL: {}, BPH: {}, L2size: {}, L1ratio: {}, L2Usize: {}, CPeps: {}, BPT: {}, WinT: {}, IntT: {}", GetRows(), GetCols(), GetBandpassL(),
-      GetBandpassH(), GetL2size(), GetL1ratio(), GetL2Usize(), GetCrossPowerEpsilon(), BandpassType2String(GetBandpassType()), WindowType2String(GetWindowType()),
-      InterpolationType2String(GetInterpolationType()));
+  return fmt::format("Rows: {}, Cols: {}, BPL: {}, BPH: {}, L2size: {}, L1ratio: {}, L2Usize: {}, CPeps: {}, BPT: {}, WinT: {}, IntT: {}, Precision: {}, HalfSpectrum: {}, "
+                     "OptimalDFTSize: {}, RemoveMean: {}, MaxShift: {}, ShiftPrediction: {}, MinPeakQuality: {}",
+      GetRows(), GetCols(), GetBandpassL(), GetBandpassH(), GetL2size(), GetL1ratio(), GetL2Usize(), GetCrossPowerEpsilon(), BandpassType2String(GetBandpassType()),
+      WindowType2String(GetWindowType()), InterpolationType2String(GetInterpolationType()), Precision2String(GetPrecision()), GetHalfSpectrum(), GetOptimalDFTSize(),
+      GetRemoveMean(), GetMaxShift(), cv::Point2d(GetShiftPrediction()), GetMinPeakQuality());
 }
 
+// L3 is unshifted, the zero shift neighborhood masked by the (inverse-shifted) circle lies at the L3 corners
 void IPC::FalseCorrelationsRemoval(cv::Mat& L3) const
 {
   const auto radius = 5;
-  const auto kirkl = 1. - Kirkl<Float>(L3.rows, L3.cols, radius);
-  Plot::Plot("FCR L3 raw", L3);
-  Plot::Plot({.name = "L2U raw", .z = CalculateL2U(CalculateL2(L3, cv::Point2d(L3.cols / 2, L3.rows / 2), 39)), .surf = true});
+  cv::Mat kirkl = 1. - Kirkl<Float>(L3.rows, L3.cols, radius);
+  IFFTShift(kirkl);
+  kirkl.convertTo(kirkl, L3.type());
+  Plot::Plot("FCR L3 raw", FFTShift(L3.clone()));
+  Plot::Plot({.name = "L2U raw", .z = CalculateL2U(CalculateL2(L3, cv::Point2i(0, 0), 39)), .surf = true});
   cv::multiply(L3, kirkl, L3);
-  Plot::Plot({.name = "L2U fcr", .z = CalculateL2U(CalculateL2(L3, cv::Point2d(L3.cols / 2, L3.rows / 2), 39)), .surf = true});
+  Plot::Plot({.name = "L2U fcr", .z = CalculateL2U(CalculateL2(L3, cv::Point2i(0, 0), 39)), .surf = true});
   throw std::runtime_error("stap xd");
 }
@@ -1,7 +1,11 @@
 #pragma once
 #include "Math/Fourier.hpp"
 #include "Math/Functions.hpp"
+#include "Math/CrossPower.hpp"
 #include "Utils/Crop.hpp"
+#include "IPCWorkspace.hpp"
+#include "IPCMaskCache.hpp"
+#include "IPCStatistics.hpp"
 #include "IPCAlign.hpp"
 #include "IPCDebug.hpp"
 #include "IPCFlow.hpp"
@@ -11,9 +15,17 @@
 class IPC
 {
 public:
-  // algorithm floating point precision, use 64-bit for most accurate results, 32-bit for performance
+  // default floating point type of images and masks used outside of the registration itself
   using Float = double;
 
+  // algorithm floating point precision, use 64-bit for most accurate results, 32-bit for performance
+  enum class Precision : uint8_t
+  {
+    Float32,       // single precision (half the memory bandwidth, twice the SIMD width)
+    Float64,       // double precision
+    PrecisionCount // last
+  };
+
   // input image DFT window type
   enum class WindowType : uint8_t
   {
@@ -37,6 +49,7 @@ public:
     NearestNeighbor,       // nearest neighbor interpolation
     Linear,                // bilinear interpolation
     Cubic,                 // bicubic interpolation
+    DFTUpsample,           // band-limited upsampling evaluated directly from the cross-power spectrum via matrix-multiply DFTs
     InterpolationTypeCount // last
   };
 
@@ -56,6 +69,50 @@ public:
     Debug   // special mode used for debugging and plotting
   };
 
+  // registration result with the correlation peak quality
+  struct Result
+  {
+    cv::Point2d shift;  // subpixel image shift (pixel level shift of rejected results)
+    double quality = 0; // peak-to-sidelobe ratio of the L3 correlation peak (0 if not evaluated)
+    bool valid = true;  // false if the peak quality is below the minimum peak quality (upsampling & iterative refinement are skipped)
+  };
+
+  // prepared reference image, holds the windowed DFT of the reference image (immutable, can be shared between threads)
+  struct Reference
+  {
+    cv::Mat dft; // windowed DFT of the reference image
+  };
+
+  // runtime configuration, the hot path reads the types and L2 sizes from the IPC parameters
+  struct DynamicConfig
+  {
+    static constexpr bool kStatic = false;
+    template <typename T>
+    struct L2Buffer
+    {
+    };
+  };
+
+  // compile-time configuration, the hot path branches on the fixed types are resolved at compile time and the fixed-size L2 is kept on the stack (see IPCStatic),
+  // the windowed L1 stays in the workspace, its size follows the runtime L1ratio and is only bounded by L2Usize (L2Usize^2 values, ~400 kB of doubles for
+  // the default L2Usize, too large for the worker thread stacks) and the binary L1 windows of the specializations are evaluated from the centroid tables
+  // without materializing L1
+  template <WindowType WinT, BandpassType BPT, InterpolationType IntT, L1WindowType L1WinT, int L2sizeT, int L2UsizeT>
+  struct StaticConfig
+  {
+    static_assert(L2sizeT >= 3 and L2sizeT % 2 == 1, "L2size has to be odd and at least 3");
+    static_assert(L2UsizeT >= L2sizeT, "L2Usize has to be at least L2size");
+    static constexpr bool kStatic = true;
+    static constexpr WindowType kWindowType = WinT;
+    static constexpr BandpassType kBandpassType = BPT;
+    static constexpr InterpolationType kInterpolationType = IntT;
+    static constexpr L1WindowType kL1WindowType = L1WinT;
+    static constexpr int kL2size = L2sizeT;
+    static constexpr int kL2Usize = L2UsizeT;
+    template <typename T>
+    using L2Buffer = cv::Matx<T, L2sizeT, L2sizeT>;
+  };
+
   // debug helper
   inline static const cv::Point2d mDefaultDebugTrueShift{123.456, 123.456};
 
@@ -74,9 +131,18 @@ private:
   InterpolationType mIntT = InterpolationType::Linear; // correlation interpolation type
   WindowType mWinT = WindowType::Hann;                 // input image DFT window type
   L1WindowType mL1WinT = L1WindowType::Circular;       // L1 window (mask) type (used to compute correlation centroids)
-  cv::Mat mBP;                                         // normalized bandpass mask applied to the cross-power spectrum
-  cv::Mat mWin;                                        // window mask applied to input images
-  cv::Mat mL1Win;                                      // L1 window mask
+  Precision mPrecision = Precision::Float64;           // algorithm floating point precision
+  bool mHalfSpectrum = false;                          // use real-to-complex CCS-packed spectra (only the non-redundant half of the Hermitian spectrum is stored)
+  bool mOptimalDFTSize = false;                        // zero-pad windowed images to the nearest larger fast DFT size (cv::getOptimalDFTSize)
+  bool mRemoveMean = false;                            // subtract the mean of each input image (channel) before windowing
+  int mMaxShift = 0;                                   // maximum expected shift from the shift prediction (0 = the full L3 is searched)
+  cv::Point2i mShiftPrediction{0, 0};                  // predicted pixel level shift, center of the plausible-shift L3 sub-grid
+  double mMinPeakQuality = 0;                          // minimum L3 peak-to-sidelobe ratio of valid results (0 = no peak quality gate)
+  cv::Mat mBP;                                         // normalized bandpass mask applied to the cross-power spectrum (in algorithm precision)
+  cv::Mat mWin;                                        // window mask applied to input images (in algorithm precision)
+  std::vector<double> mWinRows;                        // separable window row profile applied by the fused input preprocessing (empty for no window)
+  std::vector<double> mWinCols;                        // separable window column profile applied by the fused input preprocessing (empty for no window)
+  cv::Mat mL1Win;                                      // L1 window mask (in algorithm precision)
 
   // debugging and plotting helpers
   mutable std::string mDebugName = "IPC";
@@ -86,7 +152,6 @@ private:
 
   friend class IPCAlign;
   friend class IPCDebug;
-  friend class IPCFlow;
   friend class IPCMeasure;
   friend class IPCOptimization;
 
@@ -113,7 +178,7 @@ public:
     if (mWin.rows != mRows or mWin.cols != mCols)
       UpdateWindow();
 
-    if (mBP.rows != mRows or mBP.cols != mCols)
+    if (mBP.size() != GetDFTSize())
       UpdateBandpass();
   }
 
@@ -162,6 +227,35 @@ public:
     UpdateL1Window();
   }
 
+  void SetPrecision(Precision precision)
+  {
+    mPrecision = precision;
+    UpdateWindow();
+    UpdateBandpass();
+    UpdateL1Window();
+  }
+
+  void SetHalfSpectrum(bool halfSpectrum) { mHalfSpectrum = halfSpectrum; }
+
+  void SetOptimalDFTSize(bool optimalDFTSize)
+  {
+    mOptimalDFTSize = optimalDFTSize;
+    UpdateBandpass();
+  }
+
+  void SetRemoveMean(bool removeMean) { mRemoveMean = removeMean; }
+
+  // restrict the L3 peak search to shifts within maxShift pixels of the predicted shift (0 = search the full L3), the correlation is then only
+  // evaluated on the small plausible-shift sub-grid by a matrix-form inverse DFT instead of the full inverse DFT
+  void SetMaxShift(int maxShift, const cv::Point2i& prediction = {0, 0})
+  {
+    mMaxShift = std::max(maxShift, 0);
+    mShiftPrediction = prediction;
+  }
+
+  // reject results whose L3 peak-to-sidelobe ratio is below minPeakQuality right after the peak search (0 = accept all)
+  void SetMinPeakQuality(double minPeakQuality) { mMinPeakQuality = std::max(minPeakQuality, 0.); }
+
   void SetCrossPowerEpsilon(double CPeps) { mCPeps = std::max(CPeps, 0.); }
   void SetMaxIterations(int maxIterations) { mMaxIter = maxIterations; }
   void SetInterpolationType(InterpolationType interpolationType) { mIntT = interpolationType; }
@@ -185,94 +279,401 @@ public:
   int GetL2Usize() const { return mL2Usize; }
   double GetCrossPowerEpsilon() const { return mCPeps; }
   cv::Mat GetWindow() const { return mWin; }
+  const std::vector<double>& GetWindowRowProfile() const { return mWinRows; }
+  const std::vector<double>& GetWindowColProfile() const { return mWinCols; }
   cv::Mat GetBandpass() const { return mBP; }
   BandpassType GetBandpassType() const { return mBPT; }
   WindowType GetWindowType() const { return mWinT; }
   L1WindowType GetL1WindowType() const { return mL1WinT; }
   InterpolationType GetInterpolationType() const { return mIntT; }
+  Precision GetPrecision() const { return mPrecision; }
+  bool GetHalfSpectrum() const { return mHalfSpectrum; }
+  bool GetOptimalDFTSize() const { return mOptimalDFTSize; }
+  bool GetRemoveMean() const { return mRemoveMean; }
+  int GetMaxShift() const { return mMaxShift; }
+  cv::Point2i GetShiftPrediction() const { return mShiftPrediction; }
+  double GetMinPeakQuality() const { return mMinPeakQuality; }
+  cv::Size GetDFTSize() const { return mOptimalDFTSize ? cv::Size(cv::getOptimalDFTSize(mCols), cv::getOptimalDFTSize(mRows)) : cv::Size(mCols, mRows); }
+  int GetFloatType(int channels = 1) const { return mPrecision == Precision::Float32 ? GetMatType<float>(channels) : GetMatType<double>(channels); }
   double GetUpsampleCoeff() const { return static_cast<Float>(mL2Usize) / mL2size; };
   double GetUpsampleCoeff(int L2size) const { return static_cast<Float>(mL2Usize) / L2size; };
 
-  // calculate the subpixel image shift between image1 and image2
-  template <Mode ModeT = Mode::Normal>
+  // calculate the subpixel image shift between image1 and image2, uses the calling thread's workspace
+  template <Mode ModeT = Mode::Normal, typename ConfigT = DynamicConfig>
   cv::Point2d Calculate(const cv::Mat& image1, const cv::Mat& image2) const
+  {
+    return Calculate<ModeT, ConfigT>(image1, image2, GetThreadWorkspace());
+  }
+
+  // calculate the subpixel image shift between image1 and image2, input images can be non-continuous ROI views and are read directly without copies,
+  // multichannel images are registered jointly using all channels
+  template <Mode ModeT = Mode::Normal, typename ConfigT = DynamicConfig>
+  cv::Point2d Calculate(const cv::Mat& image1, const cv::Mat& image2, IPCWorkspace& workspace) const
+  {
+    return CalculateResult<ModeT, ConfigT>(image1, image2, workspace, false).shift;
+  }
+
+  // calculate the subpixel image shift between image1 and image2 together with the correlation peak quality, uses the calling thread's workspace
+  template <Mode ModeT = Mode::Normal, typename ConfigT = DynamicConfig>
+  Result CalculateResult(const cv::Mat& image1, const cv::Mat& image2) const
+  {
+    return CalculateResult<ModeT, ConfigT>(image1, image2, GetThreadWorkspace());
+  }
+
+  // calculate the subpixel image shift between image1 and image2 together with the correlation peak quality
+  template <Mode ModeT = Mode::Normal, typename ConfigT = DynamicConfig>
+  Result CalculateResult(const cv::Mat& image1, const cv::Mat& image2, IPCWorkspace& workspace) const
+  {
+    return CalculateResult<ModeT, ConfigT>(image1, image2, workspace, true);
+  }
+
+  // prepare the windowed DFT of a reference image which is then reused for registering many images against it
+  Reference PrepareReference(const cv::Mat& image) const
   {
     PROFILE_FUNCTION;
-    return Calculate<ModeT>(image1.clone(), image2.clone());
+    if (image.size() != cv::Size(mCols, mRows)) [[unlikely]]
+      throw std::invalid_argument(fmt::format("Invalid image size ({} != {})", image.size(), cv::Size(mCols, mRows)));
+
+    if (image.channels() != 1) [[unlikely]]
+      throw std::invalid_argument("Multichannel images are not supported");
+
+    cv::Mat prepared;
+    PrepareImage(image, prepared);
+    return Reference{CalculateFourierTransform(std::move(prepared))};
   }
 
-  // calculate the subpixel image shift between image1 and image2
-  template <Mode ModeT = Mode::Normal>
-  cv::Point2d Calculate(cv::Mat&& image1, cv::Mat&& image2) const
+  // calculate the subpixel image shift between a prepared reference image and image2, only image2 is transformed, uses the calling thread's workspace
+  template <Mode ModeT = Mode::Normal, typename ConfigT = DynamicConfig>
+  cv::Point2d Calculate(const Reference& reference, const cv::Mat& image2) const
+  {
+    return Calculate<ModeT, ConfigT>(reference, image2, GetThreadWorkspace());
+  }
+
+  // calculate the subpixel image shift between a prepared reference image and image2, only image2 is transformed
+  template <Mode ModeT = Mode::Normal, typename ConfigT = DynamicConfig>
+  cv::Point2d Calculate(const Reference& reference, const cv::Mat& image2, IPCWorkspace& workspace) const
   {
     PROFILE_FUNCTION;
     LOG_FUNCTION_IF(ModeT == Mode::Debug);
 
-    // verify that input images are the correct size
-    if (image1.size() != cv::Size(mCols, mRows)) [[unlikely]]
-      throw std::invalid_argument(fmt::format("Invalid image size ({} != {})", image1.size(), cv::Size(mCols, mRows)));
+    // verify that the reference was prepared for this IPC size, padding and precision
+    if (reference.dft.size() != GetDFTSize()) [[unlikely]]
+      throw std::invalid_argument(fmt::format("Invalid reference size ({} != {})", reference.dft.size(), GetDFTSize()));
 
-    // verify that input images are the same size
-    if (image1.size() != image2.size()) [[unlikely]]
-      throw std::invalid_argument(fmt::format("Image sizes differ ({} != {})", image1.size(), image2.size()));
+    if (reference.dft.type() != GetFloatType(mHalfSpectrum ? 1 : 2)) [[unlikely]]
+      throw std::invalid_argument("Reference was prepared with a different precision or spectrum layout");
+
+    // verify that the input image is the correct size
+    if (image2.size() != cv::Size(mCols, mRows)) [[unlikely]]
+      throw std::invalid_argument(fmt::format("Invalid image size ({} != {})", image2.size(), cv::Size(mCols, mRows)));
 
     // only single channel images are supported
-    if (image1.channels() != 1 or image2.channels() != 1) [[unlikely]]
+    if (image2.channels() != 1) [[unlikely]]
       throw std::invalid_argument("Multichannel images are not supported");
 
-    // convert input images to common data type and value range
-    ConvertToUnitFloat(image1);
-    ConvertToUnitFloat(image2);
+    IPCStatistics::Call statistics;
+    PrepareImage<ConfigT>(image2, workspace.image2);
+    statistics.Lap(IPCStatistics::Stage::Prepare);
+    CalculateFourierTransform(workspace.image2, workspace.dft2);
+    statistics.Lap(IPCStatistics::Stage::FFT);
+
+    if (mPrecision == Precision::Float32)
+      return CalculateShift<ModeT, ConfigT, float>(reference.dft, workspace.dft2, workspace, statistics, false).shift;
+    return CalculateShift<ModeT, ConfigT, double>(reference.dft, workspace.dft2, workspace, statistics, false).shift;
+  }
+
+  // calculate the subpixel image shift from the DFTs of two images prepared (converted, mean-removed & windowed) as by this IPC, the spectra are either
+  // full complex spectra or CCS-packed half spectra of the DFT size and IPC precision, dft2 is overwritten by the cross-power spectrum
+  template <Mode ModeT = Mode::Normal, typename ConfigT = DynamicConfig>
+  cv::Point2d CalculateFromSpectra(const cv::Mat& dft1, cv::Mat& dft2, IPCWorkspace& workspace) const
+  {
+    PROFILE_FUNCTION;
+    LOG_FUNCTION_IF(ModeT == Mode::Debug);
+
+    if (dft1.size() != GetDFTSize() or dft2.size() != GetDFTSize()) [[unlikely]]
+      throw std::invalid_argument(fmt::format("Invalid spectrum size ({} / {} != {})", dft1.size(), dft2.size(), GetDFTSize()));
+
+    if (dft1.type() != dft2.type() or (dft1.type() != GetFloatType(1) and dft1.type() != GetFloatType(2))) [[unlikely]]
+      throw std::invalid_argument("Spectra have a different precision or spectrum layout");
+
+    IPCStatistics::Call statistics;
+    if (mPrecision == Precision::Float32)
+      return CalculateShift<ModeT, ConfigT, float>(dft1, dft2, workspace, statistics, false).shift;
+    return CalculateShift<ModeT, ConfigT, double>(dft1, dft2, workspace, statistics, false).shift;
+  }
+
+  // calculate a single subpixel image shift common to all image pairs (images1[i], images2[i]), uses the calling thread's workspace
+  template <Mode ModeT = Mode::Normal, typename ConfigT = DynamicConfig>
+  cv::Point2d CalculateAccumulated(std::span<const cv::Mat> images1, std::span<const cv::Mat> images2) const
+  {
+    return CalculateAccumulated<ModeT, ConfigT>(images1, images2, GetThreadWorkspace());
+  }
+
+  // calculate a single subpixel image shift common to all image pairs (images1[i], images2[i]) from the sum of their normalized cross-power spectra,
+  // only one inverse DFT and iterative refinement are needed regardless of the number of pairs and the summed correlation peak is better conditioned
+  // than the peaks of the individual pairs
+  template <Mode ModeT = Mode::Normal, typename ConfigT = DynamicConfig>
+  cv::Point2d CalculateAccumulated(std::span<const cv::Mat> images1, std::span<const cv::Mat> images2, IPCWorkspace& workspace) const
+  {
+    PROFILE_FUNCTION;
+    LOG_FUNCTION_IF(ModeT == Mode::Debug);
+
+    if (images1.size() != images2.size()) [[unlikely]]
+      throw std::invalid_argument(fmt::format("Image pair counts differ ({} != {})", images1.size(), images2.size()));
+
+    if (images1.empty()) [[unlikely]]
+      throw std::invalid_argument("No image pairs to accumulate");
+
+    for (size_t idx = 0; idx < images1.size(); ++idx)
+      CheckInputImages(images1[idx], images2[idx]);
+
+    IPCStatistics::Call statistics;
+    if (mPrecision == Precision::Float32)
+      return CalculateAccumulated<ModeT, ConfigT, float>(images1, images2, workspace, statistics).shift;
+    return CalculateAccumulated<ModeT, ConfigT, double>(images1, images2, workspace, statistics).shift;
+  }
+
+  // workspace of the calling thread used by the Calculate overloads without an explicit workspace
+  static IPCWorkspace& GetThreadWorkspace()
+  {
+    thread_local IPCWorkspace workspace;
+    return workspace;
+  }
+
+  // calculate the subpixel image shifts between all image pairs (images1[i], images2[i]) in parallel, results are identical to calling Calculate for each pair
+  std::vector<cv::Point2d> CalculateBatch(std::span<const cv::Mat> images1, std::span<const cv::Mat> images2) const;
+
+  // calculate the accumulated subpixel image shifts of all image pair groups (images1[i], images2[i]) in parallel, results are identical to calling
+  // CalculateAccumulated for each group
+  std::vector<cv::Point2d> CalculateAccumulatedBatch(std::span<const std::vector<cv::Mat>> images1, std::span<const std::vector<cv::Mat>> images2) const;
+
+  static std::string BandpassType2String(BandpassType type);
+  static std::string WindowType2String(WindowType type);
+  static std::string L1WindowType2String(L1WindowType type);
+  static std::string InterpolationType2String(InterpolationType type);
+  static std::string Precision2String(Precision precision);
+  std::string Serialize() const;
+
+private:
+  // calculate the subpixel image shift between image1 and image2, the peak quality is evaluated if requested or needed by the peak quality gate
+  template <Mode ModeT, typename ConfigT>
+  Result CalculateResult(const cv::Mat& image1, const cv::Mat& image2, IPCWorkspace& workspace, bool quality) const
+  {
+    PROFILE_FUNCTION;
+    LOG_FUNCTION_IF(ModeT == Mode::Debug);
+
+    CheckInputImages(image1, image2);
     if constexpr (ModeT == Mode::Debug)
-      IPCDebug::DebugInputImages(*this, image1, image2);
+      IPCDebug::DebugInputImages(*this, ConvertToUnitFloat(image1), ConvertToUnitFloat(image2));
+
+    IPCStatistics::Call statistics;
+
+    // multichannel images are registered from the cross-power spectra of all channels accumulated into a single correlation surface
+    if (image1.channels() > 1)
+    {
+      if (mPrecision == Precision::Float32)
+        return CalculateMultichannel<ModeT, ConfigT, float>(image1, image2, workspace, statistics, quality);
+      return CalculateMultichannel<ModeT, ConfigT, double>(image1, image2, workspace, statistics, quality);
+    }
 
-    // apply DFT window to input images
-    ApplyWindow(image1);
-    ApplyWindow(image2);
+    // convert input images to common data type and value range and apply DFT window
+    PrepareImage<ConfigT>(image1, workspace.image1);
+    PrepareImage<ConfigT>(image2, workspace.image2);
+    statistics.Lap(IPCStatistics::Stage::Prepare);
 
     // compute the DFTs of input images
-    auto dft1 = CalculateFourierTransform(std::move(image1));
-    auto dft2 = CalculateFourierTransform(std::move(image2));
+    CalculateFourierTransform(workspace.image1, workspace.dft1);
+    CalculateFourierTransform(workspace.image2, workspace.dft2);
+    statistics.Lap(IPCStatistics::Stage::FFT);
     if constexpr (ModeT == Mode::Debug and false)
-      IPCDebug::DebugFourierTransforms(*this, dft1, dft2);
+      IPCDebug::DebugFourierTransforms(*this, workspace.dft1, workspace.dft2);
+
+    // compute the subpixel image shift from the DFTs in the selected precision
+    if (mPrecision == Precision::Float32)
+      return CalculateShift<ModeT, ConfigT, float>(workspace.dft1, workspace.dft2, workspace, statistics, quality);
+    return CalculateShift<ModeT, ConfigT, double>(workspace.dft1, workspace.dft2, workspace, statistics, quality);
+  }
+
+  // calculate the subpixel image shift from the DFTs of the windowed input images, all intermediate results are of type T
+  template <Mode ModeT, typename ConfigT, typename T>
+  Result CalculateShift(const cv::Mat& dft1, cv::Mat& dft2, IPCWorkspace& workspace, IPCStatistics::Call& statistics, bool quality) const
+  {
+    PROFILE_FUNCTION;
+
+    // compute the normalized & bandpass-filtered cross-power spectrum in place of dft2
+    cv::Mat& crosspower = dft2;
+    CalculateCrossPowerSpectrum<ConfigT, T>(dft1, crosspower);
+    statistics.Lap(IPCStatistics::Stage::CrossPower);
+    return CalculateShiftFromCrossPower<ModeT, ConfigT, T>(crosspower, workspace, statistics, quality);
+  }
+
+  // sum the normalized cross-power spectra of all channels and calculate the subpixel image shift with a single inverse DFT and iterative refinement,
+  // each channel contributes a unit magnitude spectrum so that channels of different contrast are weighted equally
+  template <Mode ModeT, typename ConfigT, typename T>
+  Result CalculateMultichannel(const cv::Mat& image1, const cv::Mat& image2, IPCWorkspace& workspace, IPCStatistics::Call& statistics, bool quality) const
+  {
+    PROFILE_FUNCTION;
+    AccumulateCrossPower<ConfigT, T>(image1, image2, workspace, statistics, true);
+    return CalculateShiftFromCrossPower<ModeT, ConfigT, T>(workspace.crosspower, workspace, statistics, quality);
+  }
+
+  // sum the normalized cross-power spectra of all image pairs (and all their channels) and calculate the common subpixel image shift with a single
+  // inverse DFT and iterative refinement
+  template <Mode ModeT, typename ConfigT, typename T>
+  Result CalculateAccumulated(std::span<const cv::Mat> images1, std::span<const cv::Mat> images2, IPCWorkspace& workspace, IPCStatistics::Call& statistics) const
+  {
+    PROFILE_FUNCTION;
+    for (size_t idx = 0; idx < images1.size(); ++idx)
+      AccumulateCrossPower<ConfigT, T>(images1[idx], images2[idx], workspace, statistics, idx == 0);
+    return CalculateShiftFromCrossPower<ModeT, ConfigT, T>(workspace.crosspower, workspace, statistics, false);
+  }
+
+  // add the normalized cross-power spectra of all channels of the image pair to workspace.crosspower, the first spectrum replaces its contents
+  template <typename ConfigT, typename T>
+  void AccumulateCrossPower(const cv::Mat& image1, const cv::Mat& image2, IPCWorkspace& workspace, IPCStatistics::Call& statistics, bool first) const
+  {
+    PROFILE_FUNCTION;
+    cv::Mat& crosspower = workspace.crosspower;
+    for (int channel = 0; channel < image1.channels(); ++channel)
+    {
+      PrepareImage<ConfigT>(image1, workspace.image1, channel);
+      PrepareImage<ConfigT>(image2, workspace.image2, channel);
+      statistics.Lap(IPCStatistics::Stage::Prepare);
+      CalculateFourierTransform(workspace.image1, workspace.dft1);
+      CalculateFourierTransform(workspace.image2, workspace.dft2);
+      statistics.Lap(IPCStatistics::Stage::FFT);
+      CalculateCrossPowerSpectrum<ConfigT, T>(workspace.dft1, workspace.dft2);
+
+      if (first and channel == 0)
+        std::swap(crosspower, workspace.dft2); // the first cross-power spectrum is taken over without a copy
+      else
+        cv::add(crosspower, workspace.dft2, crosspower);
+      statistics.Lap(IPCStatistics::Stage::CrossPower);
+    }
+  }
+
+  // verify that the input image pair matches the IPC size and each other
+  void CheckInputImages(const cv::Mat& image1, const cv::Mat& image2) const
+  {
+    // verify that input images are the correct size
+    if (image1.size() != cv::Size(mCols, mRows)) [[unlikely]]
+      throw std::invalid_argument(fmt::format("Invalid image size ({} != {})", image1.size(), cv::Size(mCols, mRows)));
+
+    // verify that input images are the same size
+    if (image1.size() != image2.size()) [[unlikely]]
+      throw std::invalid_argument(fmt::format("Image sizes differ ({} != {})", image1.size(), image2.size()));
 
-    // compute the normalized & bandpass-filtered cross-power spectrum
-    auto crosspower = CalculateCrossPowerSpectrum(std::move(dft1), std::move(dft2));
+    // verify that input images have the same number of channels
+    if (image1.channels() != image2.channels()) [[unlikely]]
+      throw std::invalid_argument(fmt::format("Image channel counts differ ({} != {})", image1.channels(), image2.channels()));
+  }
+
+  // calculate the subpixel image shift from the (possibly accumulated) cross-power spectrum
+  template <Mode ModeT, typename ConfigT, typename T>
+  Result CalculateShiftFromCrossPower(const cv::Mat& crosspower, IPCWorkspace& workspace, IPCStatistics::Call& statistics, bool quality) const
+  {
+    PROFILE_FUNCTION;
     if constexpr (ModeT == Mode::Debug)
       IPCDebug::DebugCrossPowerSpectrum(*this, crosspower);
 
-    // compute the phase correlation landscape (L3) by applying inverse DFT to the cross-power spectrum
-    cv::Mat L3 = CalculateL3(std::move(crosspower));
-    if constexpr (ModeT == Mode::Debug and false)
-      FalseCorrelationsRemoval(L3);
+    // compute the phase correlation landscape (L3) by applying inverse DFT to the cross-power spectrum, L3 is kept unshifted (zero shift at the origin),
+    // with a maximum expected shift only the plausible-shift sub-grid centered at the shift prediction is evaluated
+    cv::Mat& L3 = workspace.L3;
+    cv::Point2i L3peak;
+    cv::Point2d L3shift;
+    const int L3subsize = GetL3PartialSize(crosspower.size());
+    if (L3subsize > 0)
+    {
+      CalculateL3Partial<T>(crosspower, L3subsize, workspace, L3);
 
-    // calculate the maximum correlation location
-    cv::Point2d L3peak = GetPeak(L3);
-    cv::Point2d L3mid(L3.cols / 2, L3.rows / 2);
+      // the peak is searched within the maximum shift, the sub-grid margin only holds the L2 neighborhood
+      const int margin = L3subsize / 2 - mMaxShift;
+      L3peak = GetPeak(L3(cv::Rect(margin, margin, 2 * mMaxShift + 1, 2 * mMaxShift + 1))) + cv::Point2i(margin, margin);
+      L3shift = cv::Point2d(mShiftPrediction + L3peak - cv::Point2i(L3subsize / 2, L3subsize / 2));
+    }
+    else
+    {
+      CalculateL3(crosspower, L3);
+      if constexpr (ModeT == Mode::Debug and false)
+        FalseCorrelationsRemoval(L3);
+
+      // calculate the maximum correlation location and the corresponding pixel level shift
+      L3peak = GetPeak(L3);
+      L3shift = GetPeakShift(L3peak, L3.size());
+    }
+    statistics.Lap(IPCStatistics::Stage::L3);
     if constexpr (ModeT == Mode::Debug)
-      IPCDebug::DebugL3(*this, L3);
+      IPCDebug::DebugL3(*this, L3subsize > 0 ? L3.clone() : FFTShift(L3.clone()));
 
-    // reduce the L2size as long as the L2 is out of bounds of L3, return pixel level estimation accuracy if it cannot be reduced anymore
-    int L2size = mL2size;
-    while (IsOutOfBounds(L3peak, L3, L2size))
-      if (!ReduceL2size<ModeT>(L2size))
-        return L3peak - L3mid;
+    // reduce the L2size as long as the L2 does not fit into L3, return pixel level estimation accuracy if it cannot be reduced anymore (the static
+    // configurations are only created for IPC sizes which fit the L2)
+    int L2size = GetL2size<ConfigT>();
+    if constexpr (not ConfigT::kStatic)
+    {
+      while (L2size > L3.cols or L2size > L3.rows)
+      {
+        statistics.AddL2sizeReduction();
+        if (!ReduceL2size<ModeT>(L2size))
+        {
+          statistics.AddPixelLevel();
+          return Result{.shift = L3shift};
+        }
+      }
+    }
 
-    // extract the L2 maximum correlation neighborhood
-    cv::Mat L2 = CalculateL2(L3, L3peak, L2size);
-    cv::Point2d L2mid(L2.cols / 2, L2.rows / 2);
+    // extract the L2 maximum correlation neighborhood, the statically sized L2 is kept on the stack
+    [[maybe_unused]] typename ConfigT::template L2Buffer<T> L2buffer;
+    cv::Mat L2;
+    if constexpr (ConfigT::kStatic)
+    {
+      CalculateL2<T, ConfigT::kL2size>(L3, L3peak, L2buffer.val);
+      L2 = cv::Mat(ConfigT::kL2size, ConfigT::kL2size, GetMatType<T>(), L2buffer.val);
+    }
+    else
+    {
+      CalculateL2(L3, L3peak, L2size, workspace.L2);
+      L2 = workspace.L2;
+    }
     if constexpr (ModeT == Mode::Debug)
       IPCDebug::DebugL2(*this, L2);
 
+    // evaluate the peak quality and reject low quality peaks (e.g. of featureless images) before the upsampling & iterative refinement
+    Result result{.shift = L3shift};
+    if (quality or mMinPeakQuality > 0)
+    {
+      result.quality = GetPeakQuality<T>(L3, L3peak, L2);
+      if (result.quality < mMinPeakQuality)
+      {
+        if constexpr (ModeT == Mode::Debug)
+          LOG_WARNING("L3 peak quality {:.2f} is below the minimum peak quality {:.2f}, return pixel level shift: {}", result.quality, mMinPeakQuality, L3shift);
+        statistics.AddRejected();
+        result.valid = false;
+        return result;
+      }
+    }
+
     // upsample L2 maximum correlation neighborhood to get L2U
-    cv::Mat L2U = CalculateL2U(L2);
+    cv::Mat& L2U = workspace.L2U;
+    if (GetInterpolationType<ConfigT>() == InterpolationType::DFTUpsample)
+      CalculateL2UDFT<ConfigT, T>(crosspower, L3shift, L2size, workspace, L2U);
+    else
+      CalculateL2U<ConfigT>(L2, L2U);
     cv::Point2d L2Umid(L2U.cols / 2, L2U.rows / 2);
     if constexpr (ModeT == Mode::Debug)
       IPCDebug::DebugL2U(*this, L2, L2U);
 
+    statistics.Lap(IPCStatistics::Stage::L2U);
+
+    // the binary (none / circular) L1 windows are evaluated from summed-area tables of the L2U region visited by the L1 centroids, so that each
+    // centroid only costs one rectangle (none) or one row span per L1 row (circular) instead of a full windowed L1 pass, the tables only cover the
+    // first (largest) L1 with a margin and are only rebuilt when the iteration leaves them
+    const bool centroidTables = GetL1WindowType<ConfigT>() != L1WindowType::Gaussian;
+    cv::Rect tableRect;
+
     // initialize L1 centroid neighborhood parameters
     cv::Mat L1, L1Win;
     cv::Point2d L2Upeak, L1mid, L1peak;
+    std::vector<std::pair<int, int>> L1spans;
 
     // run the iterative refinement algorithm using the specified L1 ratio, gradually decrease L1 ratio if convergence is not achieved
     for (double L1ratio = mL1ratio; GetL1size(L2U.cols, L1ratio) > 0; L1ratio -= mL1ratioStep)
@@ -281,20 +682,23 @@ public:
       if constexpr (ModeT == Mode::Debug)
         LOG_DEBUG("Iterative refinement L1ratio: {:.2f}", L1ratio);
 
-      L2Upeak = L2Umid;                                                      // reset the accumulated L2U peak position
-      int L1size = GetL1size(L2U.cols, L1ratio);                             // calculate the current L1 size
-      L1mid = cv::Point2d(L1size / 2, L1size / 2);                           // update the L1 mid position
-      L1Win = mL1Win.cols == L1size ? mL1Win : GetL1Window(mL1WinT, L1size); // update the L1 window if necessary
+      L2Upeak = L2Umid;                                                            // reset the accumulated L2U peak position
+      int L1size = GetL1size(L2U.cols, L1ratio);                                   // calculate the current L1 size
+      L1mid = cv::Point2d(L1size / 2, L1size / 2);                                 // update the L1 mid position
+      L1Win = mL1Win.cols == L1size ? mL1Win : GetCachedL1Window<ConfigT>(L1size); // update the L1 window if necessary
+      if (centroidTables)
+        GetRowSpans<T>(L1Win, L1spans, GetL1WindowType<ConfigT>() == L1WindowType::None); // update the L1 window row spans
 
       if constexpr (ModeT == Mode::Debug and false)
-        IPCDebug::DebugL1B(*this, L2U, L1size, L3peak - L3mid, GetUpsampleCoeff(L2size));
+        IPCDebug::DebugL1B(*this, L2U, L1size, L3shift, GetUpsampleCoeff<ConfigT>(L2size));
 
       // perform the iterative refinement algorithm
       for (int iter = 0; iter < mMaxIter; ++iter)
       {
         PROFILE_SCOPE(IterativeRefinementIteration);
+        statistics.AddIteration();
         if constexpr (ModeT == Mode::Debug)
-          LOG_DEBUG("Iterative refinement {} L2Upeak: {} ({})", iter, L2Upeak, L3peak - L3mid + (L2Upeak - L2Umid + L1peak - L1mid) / GetUpsampleCoeff(L2size));
+          LOG_DEBUG("Iterative refinement {} L2Upeak: {} ({})", iter, L2Upeak, L3shift + (L2Upeak - L2Umid + L1peak - L1mid) / GetUpsampleCoeff<ConfigT>(L2size));
 
         // verify that the L1 region is withing the upsampled L2U region
         if (IsOutOfBounds(L2Upeak, L2U, L1size)) [[unlikely]]
@@ -302,9 +706,22 @@ public:
         // extract the L1 region
         L1 = CalculateL1(L2U, L2Upeak, L1size);
         if constexpr (ModeT == Mode::Debug)
-          IPCDebug::DebugL1A(*this, L1, L3peak - L3mid, L2Upeak - L2Umid, GetUpsampleCoeff(L2size));
+          IPCDebug::DebugL1A(*this, L1, L3shift, L2Upeak - L2Umid, GetUpsampleCoeff<ConfigT>(L2size));
         // calculate the centroid location using the specified L1 mask
-        L1peak = GetPeakSubpixel<true>(L1, L1Win);
+        if (centroidTables)
+        {
+          const cv::Rect L1rect(cv::Point2i(L2Upeak - L1mid), cv::Size(L1size, L1size));
+          if ((L1rect & tableRect) != L1rect)
+          {
+            const int margin = L1size / 8;
+            tableRect = (L1rect | tableRect) + cv::Size(2 * margin, 2 * margin) - cv::Point(margin, margin);
+            tableRect &= cv::Rect(0, 0, L2U.cols, L2U.rows);
+            CalculateCentroidTables<T>(L2U, tableRect, workspace.L2Usat);
+          }
+          L1peak = GetPeakSubpixel(workspace.L2Usat, tableRect, L1rect.tl(), L1size, L1spans);
+        }
+        else
+          L1peak = GetPeakSubpixel(L1, L1Win, workspace.L1);
         // add the contribution of the current iteration to the accumulated L2U peak location
         L2Upeak += cv::Point2d(std::round(L1peak.x - L1mid.x), std::round(L1peak.y - L1mid.y));
 
@@ -314,143 +731,338 @@ public:
           if constexpr (ModeT == Mode::Debug)
           {
             IPCDebug::DebugL1A(
-                *this, L1, L3peak - L3mid, L2Upeak - cv::Point2d(std::round(L1peak.x - L1mid.x), std::round(L1peak.y - L1mid.y)) - L2Umid, GetUpsampleCoeff(L2size), true);
-            LOG_DEBUG("Final IPC shift: {}", L3peak - L3mid + (L2Upeak - L2Umid + L1peak - L1mid) / GetUpsampleCoeff(L2size));
+                *this, L1, L3shift, L2Upeak - cv::Point2d(std::round(L1peak.x - L1mid.x), std::round(L1peak.y - L1mid.y)) - L2Umid, GetUpsampleCoeff<ConfigT>(L2size), true);
+            LOG_DEBUG("Final IPC shift: {}", L3shift + (L2Upeak - L2Umid + L1peak - L1mid) / GetUpsampleCoeff<ConfigT>(L2size));
           }
           // return the refined subpixel image shift
-          return L3peak - L3mid + (L2Upeak - L2Umid + L1peak - L1mid) / GetUpsampleCoeff(L2size);
+          result.shift = L3shift + (L2Upeak - L2Umid + L1peak - L1mid) / GetUpsampleCoeff<ConfigT>(L2size);
+          return result;
         }
       }
 
+      statistics.AddL1ratioReduction();
       if constexpr (ModeT == Mode::Debug)
         LOG_WARNING("L1 did not converge - reducing L1ratio: {:.2f} -> {:.2f}", L1ratio, L1ratio - mL1ratioStep);
     }
 
     if constexpr (ModeT == Mode::Debug)
-      LOG_WARNING("L1 failed to converge with all L1ratios, return non-iterative subpixel shift: {}", GetSubpixelShift<ModeT>(L3, L3peak, L3mid, L2size));
+      LOG_WARNING("L1 failed to converge with all L1ratios, return non-iterative subpixel shift: {}", GetSubpixelShift(L2, L3shift));
 
     // iterative refinement failed to converge,return non-iterative subpixel shift
-    return GetSubpixelShift<ModeT>(L3, L3peak, L3mid, L2size);
+    statistics.AddNonConverged();
+    result.shift = GetSubpixelShift(L2, L3shift);
+    return result;
   }
 
-  static std::string BandpassType2String(BandpassType type);
-  static std::string WindowType2String(WindowType type);
-  static std::string L1WindowType2String(L1WindowType type);
-  static std::string InterpolationType2String(InterpolationType type);
-  std::string Serialize() const;
+  // configuration accessors resolved at compile time for the static configurations
+  template <typename ConfigT>
+  WindowType GetWindowType() const
+  {
+    if constexpr (ConfigT::kStatic)
+      return ConfigT::kWindowType;
+    else
+      return mWinT;
+  }
 
-private:
+  template <typename ConfigT>
+  BandpassType GetBandpassType() const
+  {
+    if constexpr (ConfigT::kStatic)
+      return ConfigT::kBandpassType;
+    else
+      return mBPT;
+  }
+
+  template <typename ConfigT>
+  InterpolationType GetInterpolationType() const
+  {
+    if constexpr (ConfigT::kStatic)
+      return ConfigT::kInterpolationType;
+    else
+      return mIntT;
+  }
+
+  template <typename ConfigT>
+  L1WindowType GetL1WindowType() const
+  {
+    if constexpr (ConfigT::kStatic)
+      return ConfigT::kL1WindowType;
+    else
+      return mL1WinT;
+  }
+
+  template <typename ConfigT>
+  int GetL2size() const
+  {
+    if constexpr (ConfigT::kStatic)
+      return ConfigT::kL2size;
+    else
+      return mL2size;
+  }
+
+  template <typename ConfigT>
+  int GetL2Usize() const
+  {
+    if constexpr (ConfigT::kStatic)
+      return ConfigT::kL2Usize;
+    else
+      return mL2Usize;
+  }
+
+  template <typename ConfigT>
+  double GetUpsampleCoeff(int L2size) const
+  {
+    return static_cast<Float>(GetL2Usize<ConfigT>()) / L2size;
+  }
+
+  template <typename T = Float>
   static cv::Mat GetWindow(WindowType type, cv::Size size)
   {
     PROFILE_FUNCTION;
     switch (type)
     {
     case WindowType::Hann:
-      return Hanning<Float>(size);
+      return Hanning<T>(size);
     default:
       return cv::Mat();
     }
   }
 
+  static std::vector<double> GetWindowProfile(WindowType type, int size)
+  {
+    switch (type)
+    {
+    case WindowType::Hann:
+      return HanningProfile(size);
+    default:
+      return {};
+    }
+  }
+
+  template <typename T = Float>
   static cv::Mat GetL1Window(L1WindowType type, int size)
   {
     PROFILE_FUNCTION;
     switch (type)
     {
     case L1WindowType::Circular:
-      return Kirkl<Float>(size);
+      return Kirkl<T>(size);
     case L1WindowType::Gaussian:
-      return Gaussian<Float>(size, 0.5 * size);
+      return Gaussian<T>(size, 0.5 * size);
     default:
-      return cv::Mat::ones(size, size, GetMatType<Float>());
+      return cv::Mat::ones(size, size, GetMatType<T>());
     }
   }
 
-  void UpdateWindow() { mWin = GetWindow(mWinT, cv::Size(mCols, mRows)); }
+  void UpdateWindow()
+  {
+    const cv::Size size(mCols, mRows);
+    mWin = IPCMaskCache::Get({IPCMaskCache::Mask::Window, static_cast<int>(mWinT), size.height, size.width, GetFloatType(), 0, 0},
+        [&]() { return mPrecision == Precision::Float32 ? GetWindow<float>(mWinT, size) : GetWindow<double>(mWinT, size); });
+    mWinRows = GetWindowProfile(mWinT, size.height);
+    mWinCols = GetWindowProfile(mWinT, size.width);
+  }
+
+  void UpdateL1Window() { mL1Win = GetCachedL1Window(GetL1size(mL2Usize, mL1ratio)); }
 
-  void UpdateL1Window() { mL1Win = GetL1Window(mL1WinT, GetL1size(mL2Usize, mL1ratio)); }
+  template <typename ConfigT = DynamicConfig>
+  cv::Mat GetCachedL1Window(int size) const
+  {
+    const L1WindowType type = GetL1WindowType<ConfigT>();
+    return IPCMaskCache::Get({IPCMaskCache::Mask::L1Window, static_cast<int>(type), size, size, GetFloatType(), 0, 0},
+        [&]() { return mPrecision == Precision::Float32 ? GetL1Window<float>(type, size) : GetL1Window<double>(type, size); });
+  }
 
+  // the bandpass is always evaluated in 64-bit and then converted to the algorithm precision
   void UpdateBandpass()
+  {
+    const cv::Size size = GetDFTSize();
+    mBP = IPCMaskCache::Get({IPCMaskCache::Mask::Bandpass, static_cast<int>(mBPT), size.height, size.width, GetFloatType(), mBPL, mBPH},
+        [&]() { return ConvertToUnitFloat(CalculateBandpass()); });
+  }
+
+  // the bandpass is defined on the (possibly padded) DFT grid in normalized frequencies, so zero-padding keeps the same physical cutoffs, it is
+  // evaluated directly in the unshifted DFT layout (zero frequency at the origin)
+  cv::Mat CalculateBandpass() const
   {
     PROFILE_FUNCTION;
-    mBP = cv::Mat::ones(mRows, mCols, GetMatType<Float>());
+    const cv::Size size = GetDFTSize();
+    cv::Mat bandpass = cv::Mat::ones(size, GetMatType<Float>());
 
     if (mBPT == BandpassType::None)
-      return;
+      return bandpass;
     if (mBPL == 0 and mBPH == 0)
-      return;
+      return bandpass;
     if (mBPT == BandpassType::Rectangular and mBPL >= mBPH)
-      return;
+      return bandpass;
 
     switch (mBPT)
     {
     case BandpassType::Gaussian:
-      if (mBPL == 0 and mBPH != 0)
-      {
-        for (int r = 0; r < mRows; ++r)
-        {
-          auto bpp = mBP.ptr<Float>(r);
-          for (int c = 0; c < mCols; ++c)
-            bpp[c] = LowpassEquation(r, c);
-        }
-      }
-      else if (mBPL != 0 and mBPH == 0)
-      {
-        for (int r = 0; r < mRows; ++r)
-        {
-          auto bpp = mBP.ptr<Float>(r);
-          for (int c = 0; c < mCols; ++c)
-            bpp[c] = HighpassEquation(r, c);
-        }
-      }
-      else
+    {
+      // the gaussians are separable, exp(-(x^2 + y^2) / 2s^2) = exp(-x^2 / 2s^2) * exp(-y^2 / 2s^2), so only the 1D profiles are exponentiated
+      const bool lowpass = mBPH != 0;
+      const bool highpass = mBPL != 0;
+      const auto lowpassRows = lowpass ? GaussianProfile(size.height, mBPH) : std::vector<double>();
+      const auto lowpassCols = lowpass ? GaussianProfile(size.width, mBPH) : std::vector<double>();
+      const auto highpassRows = highpass ? GaussianProfile(size.height, mBPL) : std::vector<double>();
+      const auto highpassCols = highpass ? GaussianProfile(size.width, mBPL) : std::vector<double>();
+      for (int r = 0; r < size.height; ++r)
       {
-        for (int r = 0; r < mRows; ++r)
+        auto bpp = bandpass.ptr<Float>(r);
+        for (int c = 0; c < size.width; ++c)
         {
-          auto bpp = mBP.ptr<Float>(r);
-          for (int c = 0; c < mCols; ++c)
-            bpp[c] = BandpassGEquation(r, c);
+          if (lowpass)
+            bpp[c] *= lowpassRows[r] * lowpassCols[c];
+          if (highpass)
+            bpp[c] *= 1.0 - highpassRows[r] * highpassCols[c];
         }
-        cv::normalize(mBP, mBP, 0.0, 1.0, cv::NORM_MINMAX);
       }
+      if (lowpass and highpass)
+        cv::normalize(bandpass, bandpass, 0.0, 1.0, cv::NORM_MINMAX);
       break;
+    }
     case BandpassType::Rectangular:
-      for (int r = 0; r < mRows; ++r)
+      for (int r = 0; r < size.height; ++r)
       {
-        auto bpp = mBP.ptr<Float>(r);
-        for (int c = 0; c < mCols; ++c)
-          bpp[c] = BandpassREquation(r, c);
+        auto bpp = bandpass.ptr<Float>(r);
+        for (int c = 0; c < size.width; ++c)
+          bpp[c] = BandpassREquation(r, c, size);
       }
       break;
     default:
-      return;
+      return bandpass;
     }
 
-    IFFTShift(mBP);
+    return bandpass;
   }
 
-  double LowpassEquation(int row, int col) const
+  // 1D gaussian lowpass profile exp(-x^2 / 2s^2) over the normalized signed frequencies x = f / (size / 2)
+  static std::vector<double> GaussianProfile(int size, double sigma)
   {
-    return std::exp(-1.0 / (2. * std::pow(mBPH, 2)) * (std::pow(col - mCols / 2, 2) / std::pow(mCols / 2, 2) + std::pow(row - mRows / 2, 2) / std::pow(mRows / 2, 2)));
+    std::vector<double> profile(size);
+    for (int i = 0; i < size; ++i)
+      profile[i] = std::exp(-1.0 / (2. * std::pow(sigma, 2)) * std::pow(SignedIndex(i, size), 2) / std::pow(size / 2, 2));
+    return profile;
   }
 
-  double HighpassEquation(int row, int col) const
+  double BandpassREquation(int row, int col, cv::Size size) const
   {
-    return 1.0 - std::exp(-1.0 / (2. * std::pow(mBPL, 2)) * (std::pow(col - mCols / 2, 2) / std::pow(mCols / 2, 2) + std::pow(row - mRows / 2, 2) / std::pow(mRows / 2, 2)));
+    double r = std::sqrt(
+        0.5 * (std::pow(SignedIndex(col, size.width), 2) / std::pow(size.width / 2, 2) + std::pow(SignedIndex(row, size.height), 2) / std::pow(size.height / 2, 2)));
+    return (mBPL <= r and r <= mBPH) ? 1 : 0;
   }
 
-  double BandpassGEquation(int row, int col) const { return LowpassEquation(row, col) * HighpassEquation(row, col); }
+  void ConvertToUnitFloat(cv::Mat& image) const
+  {
+    PROFILE_FUNCTION;
+    image.convertTo(image, GetFloatType());
+  }
 
-  double BandpassREquation(int row, int col) const
+  cv::Mat ConvertToUnitFloat(const cv::Mat& image) const
   {
-    double r = std::sqrt(0.5 * (std::pow(col - mCols / 2, 2) / std::pow(mCols / 2, 2) + std::pow(row - mRows / 2, 2) / std::pow(mRows / 2, 2)));
-    return (mBPL <= r and r <= mBPH) ? 1 : 0;
+    PROFILE_FUNCTION;
+    cv::Mat converted;
+    image.convertTo(converted, GetFloatType()); // single copy straight from the (possibly non-continuous) source
+    return converted;
+  }
+
+  // convert the input image (possibly a non-continuous ROI view) to the algorithm precision, remove its mean and apply the separable DFT window in a
+  // single pass straight from the source pixels, the image is placed at the top left corner of the zero-padded DFT grid (the shift of the padded
+  // images is the same in pixels, so the L3 peak maps to the shift in the original pixel frame), the selected channel of multichannel images is prepared
+  template <typename ConfigT = DynamicConfig>
+  void PrepareImage(const cv::Mat& image, cv::Mat& prepared, int channel = 0) const
+  {
+    PROFILE_FUNCTION;
+    const cv::Size size = GetDFTSize();
+    prepared.create(size, GetFloatType());
+    if (size != image.size())
+    {
+      // only the zero-padding is cleared, the image region is fully overwritten
+      for (int row = 0; row < image.rows; ++row)
+        prepared.row(row).colRange(image.cols, size.width).setTo(0);
+      prepared.rowRange(image.rows, size.height).setTo(0);
+    }
+
+    if (mPrecision == Precision::Float32)
+      return PrepareImage<ConfigT, float>(image, prepared, channel);
+    return PrepareImage<ConfigT, double>(image, prepared, channel);
+  }
+
+  template <typename ConfigT, typename T>
+  void PrepareImage(const cv::Mat& image, cv::Mat& prepared, int channel) const
+  {
+    switch (image.depth())
+    {
+    case CV_8U:
+      return PrepareRows<ConfigT, uint8_t, T>(image, prepared, channel);
+    case CV_8S:
+      return PrepareRows<ConfigT, int8_t, T>(image, prepared, channel);
+    case CV_16U:
+      return PrepareRows<ConfigT, uint16_t, T>(image, prepared, channel);
+    case CV_16S:
+      return PrepareRows<ConfigT, int16_t, T>(image, prepared, channel);
+    case CV_32S:
+      return PrepareRows<ConfigT, int32_t, T>(image, prepared, channel);
+    case CV_32F:
+      return PrepareRows<ConfigT, float, T>(image, prepared, channel);
+    case CV_64F:
+      return PrepareRows<ConfigT, double, T>(image, prepared, channel);
+    default:
+    {
+      cv::Mat converted;
+      image.convertTo(converted, CV_64F);
+      return PrepareRows<ConfigT, double, T>(converted, prepared, channel);
+    }
+    }
+  }
+
+  template <typename ConfigT, typename S, typename T>
+  void PrepareRows(const cv::Mat& image, cv::Mat& prepared, int channel) const
+  {
+    const int channels = image.channels();
+    const bool window = GetWindowType<ConfigT>() != WindowType::None;
+    const T mean = mRemoveMean ? static_cast<T>(GetMean<S>(image, channel)) : T(0);
+    for (int row = 0; row < image.rows; ++row)
+      PrepareRow<S, T>(image.ptr<S>(row) + channel, channels, prepared.ptr<T>(row), image.cols, mean, window ? mWinRows[row] : 1., window ? mWinCols.data() : nullptr);
+  }
+
+  // fused preprocessing of one row: convert the S-typed source pixels (with a channel stride) to T, subtract the mean and apply the separable window
+  // rowWindow * colWindow[col] (nullptr for no window), the window product is evaluated in 64-bit like the full window mask
+  template <typename S, typename T>
+  static void PrepareRow(const S* source, int channels, T* prepared, int cols, T mean, double rowWindow, const double* colWindow)
+  {
+    if (channels == 1) // contiguous source rows are vectorized
+    {
+      if (colWindow)
+        for (int col = 0; col < cols; ++col)
+          prepared[col] = (static_cast<T>(source[col]) - mean) * static_cast<T>(rowWindow * colWindow[col]);
+      else
+        for (int col = 0; col < cols; ++col)
+          prepared[col] = static_cast<T>(source[col]) - mean;
+      return;
+    }
+
+    for (int col = 0; col < cols; ++col)
+      prepared[col] = (static_cast<T>(source[col * channels]) - mean) * (colWindow ? static_cast<T>(rowWindow * colWindow[col]) : T(1));
   }
 
-  static void ConvertToUnitFloat(cv::Mat& image)
+  // mean of the selected channel read directly from the source pixels
+  template <typename S>
+  static double GetMean(const cv::Mat& image, int channel)
   {
     PROFILE_FUNCTION;
-    image.convertTo(image, GetMatType<Float>());
+    const int channels = image.channels();
+    double sum = 0;
+    for (int row = 0; row < image.rows; ++row)
+    {
+      const auto imagep = image.ptr<S>(row) + channel;
+      double rowSum = 0;
+      for (int col = 0; col < image.cols; ++col)
+        rowSum += imagep[col * channels];
+      sum += rowSum;
+    }
+    return sum / image.total();
   }
 
   void ApplyWindow(cv::Mat& image) const
@@ -458,47 +1070,95 @@ private:
     PROFILE_FUNCTION;
 
     if (mWinT != WindowType::None)
-      cv::multiply(image, mWin, image);
+      cv::multiply(image, mWin, image, 1, image.type()); // explicit output type allows windowing images of other than algorithm precision
+  }
+
+  cv::Mat CalculateFourierTransform(cv::Mat&& image) const
+  {
+    PROFILE_FUNCTION;
+    return mHalfSpectrum ? PackedFFT(std::move(image)) : FFT(std::move(image));
+  }
+
+  void CalculateFourierTransform(const cv::Mat& image, cv::Mat& dft) const
+  {
+    PROFILE_FUNCTION;
+    if (mHalfSpectrum)
+      PackedFFT(image, dft);
+    else
+      FFT(image, dft);
   }
 
-  static cv::Mat CalculateFourierTransform(cv::Mat&& image)
+  // dft1 is only read so that a prepared reference spectrum can be shared between threads, its complex conjugate is applied on the fly, the all-ones
+  // bandpass of BandpassType::None is not applied
+  template <typename ConfigT, typename T>
+  void CalculateCrossPowerSpectrum(const cv::Mat& dft1, cv::Mat& dft2) const
   {
     PROFILE_FUNCTION;
-    return FFT(std::move(image));
+    const bool bandpass = GetBandpassType<ConfigT>() != BandpassType::None;
+    if (dft1.channels() == 1)
+      return CalculateCrossPowerSpectrumPacked<T>(dft1, dft2, bandpass);
+
+    const T eps = mCPeps * dft1.rows * dft1.cols;
+    CrossPowerSpectrum<T>(dft1, dft2, dft2, bandpass ? mBP : cv::Mat(), eps, true); // reuse dft2 memory
   }
 
-  cv::Mat CalculateCrossPowerSpectrum(cv::Mat&& dft1, cv::Mat&& dft2) const
+  // CCS-packed layout: columns (2k-1, 2k) hold the complex bins of column frequency k for all rows, while column 0 (and the last column for even cols)
+  // hold the purely real zero (and Nyquist) column frequency spectra packed along the rows in the same way
+  template <typename T>
+  void CalculateCrossPowerSpectrumPacked(const cv::Mat& dft1, cv::Mat& dft2, bool bandpass) const
   {
     PROFILE_FUNCTION;
-    const Float eps = mCPeps * dft1.rows * dft1.cols;
-    for (int row = 0; row < dft1.rows; ++row)
+    const int rows = dft1.rows;
+    const int cols = dft1.cols;
+    const T eps = mCPeps * rows * cols;
+    const auto level = GetSimdLevel();
+
+    // interleaved complex columns, column frequencies 1, 2, ... are contiguous in both the spectrum and the bandpass rows
+    for (int row = 0; row < rows; ++row)
+      CrossPowerSpectrum<T>(dft1.ptr<T>(row) + 1, dft2.ptr<T>(row) + 1, dft2.ptr<T>(row) + 1, bandpass ? mBP.ptr<T>(row) + 1 : nullptr, (cols - 1) / 2, eps, true,
+          level); // reuse dft2 memory
+
+    const auto band = [&](int row, int col) { return bandpass ? mBP.at<T>(row, col) : T(1); };
+    const auto packedColumn = [&](int col, int freqcol)
     {
-      auto dft1p = dft1.ptr<cv::Vec<Float, 2>>(row); // reuse dft1 memory
-      const auto dft2p = dft2.ptr<cv::Vec<Float, 2>>(row);
-      const auto bandp = mBP.ptr<Float>(row);
-      for (int col = 0; col < dft1.cols; ++col)
-      {
-        const Float re = dft1p[col][0] * dft2p[col][0] + dft1p[col][1] * dft2p[col][1];
-        const Float im = dft1p[col][0] * dft2p[col][1] - dft1p[col][1] * dft2p[col][0];
-        const Float mag = std::sqrt(re * re + im * im);
-        const Float band = bandp[col];
+      T im = 0; // purely real bins have a zero imaginary part
+      CrossPowerBin(dft1.at<T>(0, col), T(0), dft2.at<T>(0, col), T(0), dft2.at<T>(0, col), im, band(0, freqcol), eps, true);
+      for (int row = 1; row + 1 < rows; row += 2)
+        CrossPowerBin(dft1.at<T>(row, col), dft1.at<T>(row + 1, col), dft2.at<T>(row, col), dft2.at<T>(row + 1, col), dft2.at<T>(row, col), dft2.at<T>(row + 1, col),
+            band((row + 1) / 2, freqcol), eps, true);
+      if (rows % 2 == 0)
+        CrossPowerBin(dft1.at<T>(rows - 1, col), T(0), dft2.at<T>(rows - 1, col), T(0), dft2.at<T>(rows - 1, col), im, band(rows / 2, freqcol), eps, true);
+    };
+
+    packedColumn(0, 0);
+    if (cols % 2 == 0)
+      packedColumn(cols - 1, cols / 2);
+  }
 
-        dft1p[col][0] = re / (mag + eps) * band;
-        dft1p[col][1] = im / (mag + eps) * band;
-      }
-    }
-    return dft1;
+  // the inverse DFT is out of place so that the cross-power spectrum is kept (e.g. for DFT upsampling), L3 is not quadrant-swapped
+  static void CalculateL3(const cv::Mat& crosspower, cv::Mat& L3)
+  {
+    PROFILE_FUNCTION;
+    IFFT(crosspower, L3);
+  }
+
+  // size of the plausible-shift L3 sub-grid (maximum shift neighborhood of the shift prediction with an L2 margin), 0 if the full L3 is evaluated
+  int GetL3PartialSize(const cv::Size& size) const
+  {
+    const int subsize = 2 * (mMaxShift + mL2size / 2) + 1;
+    return mMaxShift > 0 and subsize < size.width and subsize < size.height ? subsize : 0;
   }
 
-  static cv::Mat CalculateL3(cv::Mat&& crosspower)
+  // evaluate the subsize x subsize L3 sub-grid centered at the shift prediction, the cost is subsize * rows * (cols / 2 + 1) complex multiply-adds instead
+  // of a full inverse DFT, the cached grid kernels do not depend on the shift prediction
+  template <typename T>
+  void CalculateL3Partial(const cv::Mat& crosspower, int subsize, IPCWorkspace& workspace, cv::Mat& L3) const
   {
     PROFILE_FUNCTION;
-    cv::Mat L3 = IFFT(std::move(crosspower));
-    FFTShift(L3);
-    return L3;
+    CalculateDFTGrid<T>(crosspower, cv::Point2d(mShiftPrediction), subsize, 1, workspace, L3);
   }
 
-  static cv::Point2d GetPeak(const cv::Mat& mat)
+  static cv::Point2i GetPeak(const cv::Mat& mat)
   {
     PROFILE_FUNCTION;
     cv::Point2i peak(0, 0);
@@ -506,6 +1166,128 @@ private:
     return peak;
   }
 
+  // peak-to-sidelobe ratio (peak - mean) / stddev of the L3 (or its plausible-shift sub-grid) sidelobe, the sidelobe excludes the L2 neighborhood
+  // of the peak, whose sums are subtracted from the L3 sums so that L3 is read only once
+  template <typename T>
+  static double GetPeakQuality(const cv::Mat& L3, const cv::Point2i& L3peak, const cv::Mat& L2)
+  {
+    PROFILE_FUNCTION;
+    const double count = static_cast<double>(L3.total()) - L2.total();
+    if (count < 2) [[unlikely]]
+      return 0;
+
+    // the excluded sums are accumulated in 64-bit, the sidelobe variance is the small difference of the L3 and L2 sums of squares
+    double L2sum = 0, L2sumsq = 0;
+    for (int row = 0; row < L2.rows; ++row)
+    {
+      const auto L2p = L2.ptr<T>(row);
+      for (int col = 0; col < L2.cols; ++col)
+      {
+        L2sum += L2p[col];
+        L2sumsq += static_cast<double>(L2p[col]) * L2p[col];
+      }
+    }
+
+    cv::Scalar mean, stddev;
+    cv::meanStdDev(L3, mean, stddev);
+    const double sum = mean[0] * L3.total() - L2sum;
+    const double sumsq = (stddev[0] * stddev[0] + mean[0] * mean[0]) * L3.total() - L2sumsq;
+    const double sidelobeMean = sum / count;
+    const double sidelobeStddev = std::sqrt(std::max(sumsq / count - sidelobeMean * sidelobeMean, 0.));
+    const double peak = L3.at<T>(L3peak);
+    return sidelobeStddev > 0 ? (peak - sidelobeMean) / sidelobeStddev : std::numeric_limits<double>::max();
+  }
+
+  // signed offset of a periodic index, indices in the upper half map to negative offsets (same convention as the DFT frequencies)
+  static int SignedIndex(int index, int size) { return index < (size + 1) / 2 ? index : index - size; }
+
+  // pixel level shift of an unshifted L3 peak
+  static cv::Point2d GetPeakShift(const cv::Point2i& peak, const cv::Size& size) { return cv::Point2d(SignedIndex(peak.x, size.width), SignedIndex(peak.y, size.height)); }
+
+  // windowed centroid, the windowed L1 is stored to the reusable buffer
+  static cv::Point2d GetPeakSubpixel(const cv::Mat& mat, const cv::Mat& L1Win, cv::Mat& buffer)
+  {
+    PROFILE_FUNCTION;
+    cv::multiply(mat, L1Win, buffer);
+    const auto m = cv::moments(buffer);
+    return cv::Point2d(m.m10 / m.m00, m.m01 / m.m00);
+  }
+
+  // summed-area tables of the values v, column weighted values x * v and row weighted values y * v of the rect region of L2U (3-channel, one row &
+  // column larger than rect, the weights are L2U coordinates)
+  template <typename T>
+  static void CalculateCentroidTables(const cv::Mat& L2U, const cv::Rect& rect, cv::Mat& tables)
+  {
+    PROFILE_FUNCTION;
+    tables.create(rect.height + 1, rect.width + 1, CV_64FC3);
+    std::fill_n(tables.ptr<cv::Vec3d>(0), tables.cols, cv::Vec3d::all(0));
+    for (int row = 0; row < rect.height; ++row)
+    {
+      const auto L2Up = L2U.ptr<T>(rect.y + row) + rect.x;
+      const auto prevp = tables.ptr<cv::Vec3d>(row);
+      auto tablesp = tables.ptr<cv::Vec3d>(row + 1);
+      cv::Vec3d rowSum = cv::Vec3d::all(0);
+      tablesp[0] = rowSum;
+      for (int col = 0; col < rect.width; ++col)
+      {
+        const double value = L2Up[col];
+        rowSum += cv::Vec3d(value, (rect.x + col) * value, (rect.y + row) * value);
+        tablesp[col + 1] = prevp[col + 1] + rowSum;
+      }
+    }
+  }
+
+  // [begin, end) column spans of the nonzero values of each row of a binary mask with convex rows, no spans for a full mask
+  template <typename T>
+  static void GetRowSpans(const cv::Mat& mask, std::vector<std::pair<int, int>>& spans, bool full)
+  {
+    PROFILE_FUNCTION;
+    spans.clear();
+    if (full)
+      return;
+
+    for (int row = 0; row < mask.rows; ++row)
+    {
+      const auto maskp = mask.ptr<T>(row);
+      int begin = 0, end = mask.cols;
+      while (begin < end and maskp[begin] == 0)
+        ++begin;
+      while (end > begin and maskp[end - 1] == 0)
+        --end;
+      spans.emplace_back(begin, end);
+    }
+  }
+
+  // windowed L1 centroid (in L1 coordinates) of the size x size L1 at the L2U position topleft from the summed-area tables of the tableRect region of
+  // L2U (which contains the L1), the binary window is given by its row spans (no spans for a full window)
+  static cv::Point2d GetPeakSubpixel(
+      const cv::Mat& tables, const cv::Rect& tableRect, const cv::Point2i& topleft, int size, const std::vector<std::pair<int, int>>& spans)
+  {
+    PROFILE_FUNCTION;
+    const auto rectangleSum = [&](int row0, int row1, int col0, int col1)
+    {
+      const auto tables0 = tables.ptr<cv::Vec3d>(row0 - tableRect.y);
+      const auto tables1 = tables.ptr<cv::Vec3d>(row1 - tableRect.y);
+      col0 -= tableRect.x;
+      col1 -= tableRect.x;
+      return tables1[col1] - tables1[col0] - tables0[col1] + tables0[col0];
+    };
+
+    cv::Vec3d sum = cv::Vec3d::all(0);
+    if (spans.empty())
+      sum = rectangleSum(topleft.y, topleft.y + size, topleft.x, topleft.x + size);
+    else
+      for (int row = 0; row < size; ++row)
+        if (spans[row].first < spans[row].second)
+          sum += rectangleSum(topleft.y + row, topleft.y + row + 1, topleft.x + spans[row].first, topleft.x + spans[row].second);
+
+    // shift the moments from L2U to L1 coordinates
+    const double m00 = sum[0];
+    const double m10 = sum[1] - topleft.x * m00;
+    const double m01 = sum[2] - topleft.y * m00;
+    return cv::Point2d(m10 / m00, m01 / m00);
+  }
+
   template <bool Window>
   static cv::Point2d GetPeakSubpixel(const cv::Mat& mat, const cv::Mat& L1Win)
   {
@@ -522,33 +1304,213 @@ private:
     }
   }
 
-  static cv::Mat CalculateL2(const cv::Mat& L3, const cv::Point2d& L3peak, int L2size)
+  // L3 is periodic, so the L2 neighborhood wraps around the L3 edges (the zero shift neighborhood is split between the L3 corners)
+  static void CalculateL2(const cv::Mat& L3, const cv::Point2i& L3peak, int L2size, cv::Mat& L2)
   {
     PROFILE_FUNCTION;
-    return RoiCrop(L3, L3peak.x, L3peak.y, L2size, L2size);
+    L2.create(L2size, L2size, L3.type());
+    const size_t elemSize = L3.elemSize();
+    for (int row = 0; row < L2size; ++row)
+    {
+      const auto L3p = L3.ptr<uint8_t>((L3peak.y + row - L2size / 2 + L3.rows) % L3.rows);
+      auto L2p = L2.ptr<uint8_t>(row);
+      for (int col = 0; col < L2size; ++col)
+        std::memcpy(L2p + col * elemSize, L3p + ((L3peak.x + col - L2size / 2 + L3.cols) % L3.cols) * elemSize, elemSize);
+    }
   }
 
-  cv::Mat CalculateL2U(const cv::Mat& L2) const
+  // fixed-size L2 (row-major L2size x L2size buffer), the compile-time trip counts let the copy be fully unrolled
+  template <typename T, int L2size>
+  static void CalculateL2(const cv::Mat& L3, const cv::Point2i& L3peak, T* L2)
   {
     PROFILE_FUNCTION;
+    for (int row = 0; row < L2size; ++row)
+    {
+      const auto L3p = L3.ptr<T>((L3peak.y + row - L2size / 2 + L3.rows) % L3.rows);
+      for (int col = 0; col < L2size; ++col)
+        L2[row * L2size + col] = L3p[(L3peak.x + col - L2size / 2 + L3.cols) % L3.cols];
+    }
+  }
+
+  static cv::Mat CalculateL2(const cv::Mat& L3, const cv::Point2i& L3peak, int L2size)
+  {
+    cv::Mat L2;
+    CalculateL2(L3, L3peak, L2size, L2);
+    return L2;
+  }
 
+  cv::Mat CalculateL2U(const cv::Mat& L2) const
+  {
     cv::Mat L2U;
-    switch (mIntT)
+    CalculateL2U(L2, L2U);
+    return L2U;
+  }
+
+  template <typename ConfigT = DynamicConfig>
+  void CalculateL2U(const cv::Mat& L2, cv::Mat& L2U) const
+  {
+    PROFILE_FUNCTION;
+    const int L2Usize = GetL2Usize<ConfigT>();
+    switch (GetInterpolationType<ConfigT>())
     {
     case InterpolationType::NearestNeighbor:
-      cv::resize(L2, L2U, {mL2Usize, mL2Usize}, 0, 0, cv::INTER_NEAREST);
+      cv::resize(L2, L2U, {L2Usize, L2Usize}, 0, 0, cv::INTER_NEAREST);
       break;
     case InterpolationType::Linear:
-      cv::resize(L2, L2U, {mL2Usize, mL2Usize}, 0, 0, cv::INTER_LINEAR);
+      cv::resize(L2, L2U, {L2Usize, L2Usize}, 0, 0, cv::INTER_LINEAR);
       break;
     case InterpolationType::Cubic:
-      cv::resize(L2, L2U, {mL2Usize, mL2Usize}, 0, 0, cv::INTER_CUBIC);
+      cv::resize(L2, L2U, {L2Usize, L2Usize}, 0, 0, cv::INTER_CUBIC);
       break;
     default:
       break;
     }
+  }
 
-    return L2U;
+  // evaluate the band-limited correlation surface on the L2U grid centered at the L3 shift
+  template <typename ConfigT, typename T>
+  void CalculateL2UDFT(const cv::Mat& crosspower, const cv::Point2d& L3shift, int L2size, IPCWorkspace& workspace, cv::Mat& L2U) const
+  {
+    PROFILE_FUNCTION;
+    CalculateDFTGrid<T>(crosspower, L3shift, GetL2Usize<ConfigT>(), GetUpsampleCoeff<ConfigT>(L2size), workspace, L2U);
+  }
+
+  // evaluate the band-limited correlation surface on the size x size grid of positions center + (j - size / 2) / UC, grid = Re(Kr * CP * Kc^T) / (rows * cols),
+  // the kernels exp(i 2pi f x / N) factorize into the per-call phase ramp exp(i 2pi f center / N), which is applied to the spectrum, and the cached grid
+  // offset kernels, only the non-redundant half of the Hermitian spectrum is summed (read directly from the CCS layout of packed spectra)
+  template <typename T>
+  static void CalculateDFTGrid(const cv::Mat& crosspower, const cv::Point2d& center, int size, double UC, IPCWorkspace& workspace, cv::Mat& grid)
+  {
+    PROFILE_FUNCTION;
+    const int rows = crosspower.rows;
+    const int cols = crosspower.cols;
+    const cv::Mat spectrum = GetHalfSpectrum<T>(crosspower, workspace.halfSpectrum);
+    const cv::Mat kernelRows = GetDFTGridKernel<T>(rows, size, UC, false);
+    const cv::Mat kernelCols = GetDFTGridKernel<T>(cols, size, UC, true);
+
+    cv::gemm(kernelRows, ApplyPhaseRamp<T>(spectrum, center, cols, workspace), 1, cv::noArray(), 0, workspace.gridRows); // size x (cols / 2 + 1)
+    cv::gemm(workspace.gridRows, kernelCols, 1. / (rows * cols), cv::noArray(), 0, workspace.grid);                    // size x size
+    cv::extractChannel(workspace.grid, grid, 0);
+  }
+
+  // multiply the half spectrum by the phase ramp exp(i 2pi (fr center.y / rows + fc center.x / cols)) which moves the evaluated grid to the center
+  template <typename T>
+  static cv::Mat ApplyPhaseRamp(const cv::Mat& spectrum, const cv::Point2d& center, int cols, IPCWorkspace& workspace)
+  {
+    PROFILE_FUNCTION;
+    const int rows = spectrum.rows;
+    if (center.x == 0 and center.y == 0)
+      return spectrum;
+
+    using Complex = std::complex<T>;
+    cv::Mat& ramp = workspace.ramp;
+    ramp.create(1, rows + spectrum.cols, CV_64FC2);
+    const auto rampp = ramp.ptr<std::complex<double>>();
+    for (int row = 0; row < rows; ++row)
+      rampp[row] = std::polar(1., 2 * std::numbers::pi * SignedIndex(row, rows) * center.y / rows);
+    for (int col = 0; col < spectrum.cols; ++col)
+      rampp[rows + col] = std::polar(1., 2 * std::numbers::pi * SignedIndex(col, cols) * center.x / cols);
+
+    workspace.ramped.create(spectrum.size(), spectrum.type());
+    for (int row = 0; row < rows; ++row)
+    {
+      const auto spectrump = spectrum.ptr<Complex>(row);
+      auto rampedp = workspace.ramped.ptr<Complex>(row);
+      const Complex rowRamp(rampp[row]);
+      for (int col = 0; col < spectrum.cols; ++col)
+        rampedp[col] = spectrump[col] * rowRamp * Complex(rampp[rows + col]);
+    }
+    return workspace.ramped;
+  }
+
+  // cached inverse DFT kernel exp(i 2pi f (j - size / 2) / (UC N)) of the grid offsets, the column kernel is transposed and restricted to the non-redundant
+  // column frequencies, each of which (except the zero and Nyquist frequencies) also accounts for its Hermitian counterpart N - f
+  template <typename T>
+  static cv::Mat GetDFTGridKernel(int N, int size, double UC, bool cols)
+  {
+    return IPCMaskCache::Get({IPCMaskCache::Mask::DFTGridKernel, static_cast<int>(cols), size, N, GetMatType<T>(2), UC, 0},
+        [&]()
+        {
+          cv::Mat kernel = GetUpsampleKernel<T>(N, size, 0, UC);
+          if (not cols)
+            return kernel;
+
+          cv::Mat halfKernel = kernel.colRange(0, N / 2 + 1).clone();
+          for (int j = 0; j < size; ++j)
+          {
+            auto kernelp = halfKernel.ptr<cv::Vec<T, 2>>(j);
+            for (int f = 1; f <= (N - 1) / 2; ++f)
+            {
+              kernelp[f][0] *= 2;
+              kernelp[f][1] *= 2;
+            }
+          }
+          cv::transpose(halfKernel, kernel);
+          return kernel;
+        });
+  }
+
+  // non-redundant complex columns 0 .. cols / 2 of the spectrum, the remaining columns are their Hermitian counterparts F(-r, -c) = conj(F(r, c)), a full
+  // complex spectrum is referenced, a CCS-packed spectrum is read into the buffer
+  template <typename T>
+  static cv::Mat GetHalfSpectrum(const cv::Mat& spectrum, cv::Mat& buffer)
+  {
+    PROFILE_FUNCTION;
+    const int rows = spectrum.rows;
+    const int cols = spectrum.cols;
+    if (spectrum.channels() == 2)
+      return spectrum.colRange(0, cols / 2 + 1);
+
+    buffer.create(rows, cols / 2 + 1, GetMatType<T>(2));
+    for (int row = 0; row < rows; ++row)
+    {
+      const auto packedp = spectrum.ptr<T>(row);
+      auto halfp = buffer.ptr<cv::Vec<T, 2>>(row);
+      for (int col = 1; col + 1 < cols; col += 2)
+        halfp[(col + 1) / 2] = {packedp[col], packedp[col + 1]};
+    }
+
+    // the zero (and Nyquist) frequency columns are packed along the rows
+    const auto packedColumn = [&](int col, int freqcol)
+    {
+      const auto set = [&](int row, T re, T im)
+      {
+        buffer.at<cv::Vec<T, 2>>(row, freqcol) = {re, im};
+        buffer.at<cv::Vec<T, 2>>((rows - row) % rows, freqcol) = {re, -im};
+      };
+
+      set(0, spectrum.at<T>(0, col), 0);
+      for (int row = 1; row + 1 < rows; row += 2)
+        set((row + 1) / 2, spectrum.at<T>(row, col), spectrum.at<T>(row + 1, col));
+      if (rows % 2 == 0)
+        set(rows / 2, spectrum.at<T>(rows - 1, col), 0);
+    };
+
+    packedColumn(0, 0);
+    if (cols % 2 == 0)
+      packedColumn(cols - 1, cols / 2);
+
+    return buffer;
+  }
+
+  // complex inverse DFT kernel exp(i 2pi f x / size) evaluated at signed frequencies f and upsampled sample positions x = shift + (j - L2Umid) / UC
+  template <typename T>
+  static cv::Mat GetUpsampleKernel(int size, int L2Usize, double shift, double UC)
+  {
+    PROFILE_FUNCTION;
+    cv::Mat kernel(L2Usize, size, GetMatType<T>(2));
+    for (int j = 0; j < L2Usize; ++j)
+    {
+      const double x = shift + (j - L2Usize / 2) / UC;
+      auto kernelp = kernel.ptr<cv::Vec<T, 2>>(j);
+      for (int f = 0; f < size; ++f)
+      {
+        const double phase = 2 * std::numbers::pi * SignedIndex(f, size) * x / size;
+        kernelp[f][0] = std::cos(phase);
+        kernelp[f][1] = std::sin(phase);
+      }
+    }
+    return kernel;
   }
 
   static int GetL1size(int L2Usize, double L1ratio)
@@ -577,18 +1539,13 @@ private:
     return L2size >= 3;
   }
 
-  template <Mode ModeT = Mode::Normal>
-  cv::Point2d GetSubpixelShift(const cv::Mat& L3, const cv::Point2d& L3peak, const cv::Point2d& L3mid, int L2size) const
+  // non-iterative subpixel shift from the L2 centroid
+  static cv::Point2d GetSubpixelShift(const cv::Mat& L2, const cv::Point2d& L3shift)
   {
     PROFILE_FUNCTION;
-    while (IsOutOfBounds(L3peak, L3, L2size))
-      if (!ReduceL2size<ModeT>(L2size))
-        return L3peak - L3mid;
-
-    cv::Mat L2 = CalculateL2(L3, L3peak, L2size);
-    cv::Point2d L2peak = GetPeakSubpixel<false>(L2, cv::Mat());
-    cv::Point2d L2mid(L2.cols / 2, L2.rows / 2);
-    return L3peak - L3mid + L2peak - L2mid;
+    const cv::Point2d L2peak = GetPeakSubpixel<false>(L2, cv::Mat());
+    const cv::Point2d L2mid(L2.cols / 2, L2.rows / 2);
+    return L3shift + L2peak - L2mid;
   }
 
   void FalseCorrelationsRemoval(cv::Mat& L3) const;
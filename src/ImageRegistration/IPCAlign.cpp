@@ -27,8 +27,8 @@ cv::Mat IPCAlign::Align(const IPC& ipc, cv::Mat&& image1, cv::Mat&& image2)
   cv::Mat img2W = image2.clone();
   ipc.ApplyWindow(img1W);
   ipc.ApplyWindow(img2W);
-  cv::Mat img1FT = FFT(img1W);
-  cv::Mat img2FT = FFT(img2W);
+  cv::Mat img1FT = FFT(std::move(img1W));
+  cv::Mat img2FT = FFT(std::move(img2W));
   FFTShift(img1FT);
   FFTShift(img2FT);
   cv::Mat img1FTm = cv::Mat(img1FT.size(), GetMatType<IPC::Float>());
@@ -29,8 +29,10 @@ void IPCDebug::DebugFourierTransforms(const IPC& ipc, const cv::Mat& dft1, const
 
 void IPCDebug::DebugCrossPowerSpectrum(const IPC& ipc, const cv::Mat& crosspower)
 {
-  Plot::Plot({.name = fmt::format("{} CP magnitude", ipc.mDebugName), .z = FFTShift(Magnitude(crosspower)), .cmap = "jet"});
-  Plot::Plot({.name = fmt::format("{} CP Phase", ipc.mDebugName), .z = FFTShift(Phase(crosspower)), .cmap = "jet"});
+  // unpack the CCS-packed half spectrum to the full complex spectrum for plotting
+  const cv::Mat spectrum = crosspower.channels() == 1 ? FFT(IFFT(crosspower.clone())) : crosspower;
+  Plot::Plot({.name = fmt::format("{} CP magnitude", ipc.mDebugName), .z = FFTShift(Magnitude(spectrum)), .cmap = "jet"});
+  Plot::Plot({.name = fmt::format("{} CP Phase", ipc.mDebugName), .z = FFTShift(Phase(spectrum)), .cmap = "jet"});
 }
 
 void IPCDebug::DebugL3(const IPC& ipc, const cv::Mat& L3)
@@ -73,7 +75,8 @@ void IPCDebug::DebugL2U(const IPC& ipc, const cv::Mat& L2, const cv::Mat& L2U)
 
 void IPCDebug::DebugL1B(const IPC& ipc, const cv::Mat& L2U, int L1size, const cv::Point2d& L3shift, double UC)
 {
-  cv::Mat mat = IPC::CalculateL1(L2U, cv::Point(L2U.cols / 2, L2U.rows / 2), L1size).clone();
+  cv::Mat mat;
+  IPC::CalculateL1(L2U, cv::Point(L2U.cols / 2, L2U.rows / 2), L1size).convertTo(mat, GetMatType<IPC::Float>());
   cv::normalize(mat, mat, 0, 1, cv::NORM_MINMAX); // for black crosshairs + cross
   mat = mat.mul(IPC::GetL1Window(ipc.mL1WinT, mat.rows));
   DrawCrosshairs(mat);
@@ -88,7 +91,8 @@ void IPCDebug::DebugL1B(const IPC& ipc, const cv::Mat& L2U, int L1size, const cv
 
 void IPCDebug::DebugL1A(const IPC& ipc, const cv::Mat& L1, const cv::Point2d& L3shift, const cv::Point2d& L2Ushift, double UC, bool last)
 {
-  cv::Mat mat = L1.clone();
+  cv::Mat mat;
+  L1.convertTo(mat, GetMatType<IPC::Float>());
   cv::normalize(mat, mat, 0, 1, cv::NORM_MINMAX); // for black crosshairs + cross
   mat = mat.mul(IPC::GetL1Window(ipc.mL1WinT, mat.rows));
   DrawCrosshairs(mat);
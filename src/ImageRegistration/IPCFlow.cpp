@@ -1,48 +1,770 @@
 #include "IPCFlow.hpp"
 #include "IPC.hpp"
+#include "IPCPyramid.hpp"
+#include "IPCStatic.hpp"
+#include "Utils/ParallelFor.hpp"
 
-std::tuple<cv::Mat, cv::Mat> IPCFlow::CalculateFlow(const IPC& ipc, const cv::Mat& image1, const cv::Mat& image2, double resolution)
+// the images are only read through ROI views, so no copies are needed
+std::tuple<cv::Mat, cv::Mat> IPCFlow::CalculateFlow(const IPC& ipc, cv::Mat&& image1, cv::Mat&& image2, double resolution, Spectra spectra)
 {
-  return CalculateFlow(ipc, image1.clone(), image2.clone(), resolution);
+  return CalculateFlow(ipc, static_cast<const cv::Mat&>(image1), static_cast<const cv::Mat&>(image2), resolution, spectra);
 }
 
-std::tuple<cv::Mat, cv::Mat> IPCFlow::CalculateFlow(const IPC& ipc, cv::Mat&& image1, cv::Mat&& image2, double resolution)
-try
+std::tuple<cv::Mat, cv::Mat> IPCFlow::CalculateFlow(const IPC& ipc, const cv::Mat& image1, const cv::Mat& image2, double resolution, Spectra spectra)
 {
   PROFILE_FUNCTION;
-  if (image1.size() != image2.size())
-    throw std::runtime_error(fmt::format("Image sizes differ ({} != {})", image1.size(), image2.size()));
+  if (image1.size() != image2.size()) [[unlikely]]
+    throw std::invalid_argument(fmt::format("Image sizes differ ({} != {})", image1.size(), image2.size()));
 
-  if (ipc.mRows > image1.rows or ipc.mCols > image1.cols)
-    throw std::runtime_error(fmt::format("Images are too small ({} < {})", image1.size(), cv::Size(ipc.mCols, ipc.mRows)));
+  if (ipc.GetRows() > image1.rows or ipc.GetCols() > image1.cols) [[unlikely]]
+    throw std::invalid_argument(fmt::format("Images are too small ({} < {})", image1.size(), cv::Size(ipc.GetCols(), ipc.GetRows())));
 
-  cv::Mat flowX = cv::Mat(cv::Size(resolution * image1.cols, resolution * image1.rows), GetMatType<IPC::Float>());
-  cv::Mat flowY = cv::Mat(cv::Size(resolution * image2.cols, resolution * image2.rows), GetMatType<IPC::Float>());
+  cv::Mat flowX = cv::Mat::zeros(cv::Size(resolution * image1.cols, resolution * image1.rows), GetMatType<IPC::Float>());
+  cv::Mat flowY = cv::Mat::zeros(cv::Size(resolution * image2.cols, resolution * image2.rows), GetMatType<IPC::Float>());
+
+  if (IsShared(ipc, spectra, std::max(image1.channels(), image2.channels())))
+  {
+    if (ipc.GetPrecision() == IPC::Precision::Float32)
+      CalculateFlowShared<float>(ipc, image1, image2, resolution, flowX, flowY);
+    else
+      CalculateFlowShared<double>(ipc, image1, image2, resolution, flowX, flowY);
+  }
+  else
+    CalculateFlowWindows(ipc, image1, image2, resolution, flowX, flowY);
+
+  return {flowX, flowY};
+}
+
+std::tuple<cv::Mat, cv::Mat> IPCFlow::CalculateFlowPyramid(const IPC& ipc, const cv::Mat& image1, const cv::Mat& image2, double resolution, int levels)
+{
+  PROFILE_FUNCTION;
+  if (levels < 0) [[unlikely]]
+    throw std::invalid_argument(fmt::format("Invalid pyramid level count ({} < 0)", levels));
+
+  if (image1.size() != image2.size()) [[unlikely]]
+    throw std::invalid_argument(fmt::format("Image sizes differ ({} != {})", image1.size(), image2.size()));
+
+  std::vector<cv::Mat> pyramid1, pyramid2;
+  IPCPyramid::BuildPyramid(image1, pyramid1, levels);
+  IPCPyramid::BuildPyramid(image2, pyramid2, levels);
+  if (ipc.GetRows() > pyramid1[levels].rows or ipc.GetCols() > pyramid1[levels].cols) [[unlikely]]
+    throw std::invalid_argument(fmt::format("Images are too small for {} pyramid levels ({} < {})", levels, pyramid1[levels].size(), cv::Size(ipc.GetCols(), ipc.GetRows())));
+
+  // the coarsest level registers the full motion, which is small in its pixels
+  auto [flowX, flowY] = CalculateFlow(ipc, pyramid1[levels], pyramid2[levels], resolution);
+
+  for (int level = levels - 1; level >= 0; --level)
+  {
+    LOG_DEBUG("Calculating IPC flow pyramid level {}", level);
+
+    // flow outside of the valid windows of the coarser level is extended from the nearest valid flow, the prior is upsampled to the flow of the finer
+    // level and its shifts double
+    const cv::Rect valid = GetValidFlowRect(ipc, pyramid1[level + 1].size(), flowX.size(), resolution);
+    const cv::Size flowSize(resolution * pyramid1[level].cols, resolution * pyramid1[level].rows);
+    cv::Mat priorX, priorY, extended;
+    for (auto [flow, prior] : {std::pair{&flowX, &priorX}, std::pair{&flowY, &priorY}})
+    {
+      if (valid.empty())
+        extended = cv::Mat::zeros(flow->size(), flow->type());
+      else
+        cv::copyMakeBorder((*flow)(valid), extended, valid.y, flow->rows - valid.br().y, valid.x, flow->cols - valid.br().x, cv::BORDER_REPLICATE);
+      cv::resize(extended, *prior, flowSize, 0, 0, cv::INTER_LINEAR);
+      *prior *= 2;
+    }
+
+    flowX = cv::Mat::zeros(flowSize, GetMatType<IPC::Float>());
+    flowY = cv::Mat::zeros(flowSize, GetMatType<IPC::Float>());
+    CalculateFlowWindows(ipc, pyramid1[level], pyramid2[level], resolution, flowX, flowY, priorX, priorY);
+  }
+
+  return {flowX, flowY};
+}
+
+void IPCFlow::CalculateFlowTiled(
+    const IPC& ipc, const cv::Size& imageSize, double resolution, const TileSource& source, const TileSink& sink, int tileSize, Spectra spectra)
+{
+  PROFILE_FUNCTION;
+  if (tileSize < 1) [[unlikely]]
+    throw std::invalid_argument(fmt::format("Invalid flow tile size ({} < 1)", tileSize));
+
+  if (ipc.GetRows() > imageSize.height or ipc.GetCols() > imageSize.width) [[unlikely]]
+    throw std::invalid_argument(fmt::format("Images are too small ({} < {})", imageSize, cv::Size(ipc.GetCols(), ipc.GetRows())));
+
+  const cv::Size flowSize(resolution * imageSize.width, resolution * imageSize.height);
+  const int tilesX = (flowSize.width + tileSize - 1) / tileSize;
+  const int tilesY = (flowSize.height + tileSize - 1) / tileSize;
+  const cv::Mat windowSpectrum = not ipc.GetRemoveMean() or not IsShared(ipc, spectra, 1) ? cv::Mat()
+                                 : ipc.GetPrecision() == IPC::Precision::Float32          ? CalculateWindowMaskSpectrum<float>(ipc)
+                                                                                          : CalculateWindowMaskSpectrum<double>(ipc);
+  const auto engine = CreateIPCEngine(ipc);
   std::atomic<int> progress = 0;
 
-#pragma omp parallel for
-  for (int r = 0; r < flowX.rows; ++r)
+  // tiles are scheduled dynamically, so tiles without inside windows (image borders) do not stall the other threads
+  ParallelFor(tilesX * tilesY,
+      [&](int tile)
+      {
+        const cv::Rect flowRect = cv::Rect(tile % tilesX * tileSize, tile / tilesX * tileSize, tileSize, tileSize) & cv::Rect(cv::Point(0, 0), flowSize);
+        const cv::Rect imageRect = GetTileImageRect(ipc, imageSize, flowRect, resolution);
+        cv::Mat flowX = cv::Mat::zeros(flowRect.size(), GetMatType<IPC::Float>());
+        cv::Mat flowY = cv::Mat::zeros(flowRect.size(), GetMatType<IPC::Float>());
+
+        if (not imageRect.empty())
+        {
+          cv::Mat image1, image2;
+          source(imageRect, image1, image2);
+          if (image1.size() != imageRect.size() or image2.size() != imageRect.size()) [[unlikely]]
+            throw std::invalid_argument(fmt::format("Invalid image tile size ({} / {} != {})", image1.size(), image2.size(), imageRect.size()));
+
+          // flow rows of the tile are registered sequentially by this thread, the shared path reuses its bands over the tile width
+          if (IsShared(ipc, spectra, std::max(image1.channels(), image2.channels())))
+          {
+            for (int r = flowRect.y; r < flowRect.br().y; ++r)
+            {
+              if (ipc.GetPrecision() == IPC::Precision::Float32)
+                CalculateFlowRow<float>(ipc, image1, image2, imageRect.tl(), imageSize, resolution, windowSpectrum, flowRect, r, flowX, flowY);
+              else
+                CalculateFlowRow<double>(ipc, image1, image2, imageRect.tl(), imageSize, resolution, windowSpectrum, flowRect, r, flowX, flowY);
+            }
+          }
+          else
+            CalculateTileWindows(*engine, image1, image2, imageRect.tl(), imageSize, resolution, flowRect, flowX, flowY);
+        }
+
+        sink(flowRect, flowX, flowY);
+
+        if (const int done = ++progress; done % std::max(tilesX * tilesY / 20, 1) == 0)
+          LOG_DEBUG("Calculating IPC flow tiles ({:.0f}%)", static_cast<double>(done) / (tilesX * tilesY) * 100);
+      });
+}
+
+void IPCFlow::CalculateFlowTiled(
+    const IPC& ipc, const cv::Mat& image1, const cv::Mat& image2, double resolution, cv::Mat& flowX, cv::Mat& flowY, int tileSize, Spectra spectra)
+{
+  PROFILE_FUNCTION;
+  if (image1.size() != image2.size()) [[unlikely]]
+    throw std::invalid_argument(fmt::format("Image sizes differ ({} != {})", image1.size(), image2.size()));
+
+  const cv::Size flowSize(resolution * image1.cols, resolution * image1.rows);
+  for (auto flow : {&flowX, &flowY})
+  {
+    if (flow->empty())
+      flow->create(flowSize, GetMatType<IPC::Float>());
+    else if (flow->size() != flowSize or flow->type() != GetMatType<IPC::Float>()) [[unlikely]]
+      throw std::invalid_argument(fmt::format("Preallocated flow does not match the flow size / type ({} != {})", flow->size(), flowSize));
+  }
+
+  CalculateFlowTiled(
+      ipc, image1.size(), resolution,
+      [&](const cv::Rect& rect, cv::Mat& tile1, cv::Mat& tile2)
+      {
+        tile1 = image1(rect);
+        tile2 = image2(rect);
+      },
+      [&](const cv::Rect& flowRect, const cv::Mat& tileX, const cv::Mat& tileY)
+      {
+        cv::Mat outX = flowX(flowRect), outY = flowY(flowRect); // ROI views write into the preallocated flow
+        tileX.copyTo(outX);
+        tileY.copyTo(outY);
+      },
+      tileSize, spectra);
+}
+
+void IPCFlow::CalculateFlowSequenceTiled(const IPC& ipc, const cv::Size& imageSize, int frames, double resolution, const SequenceTileSource& source,
+    const SequenceTileSink& sink, int tileSize, Spectra spectra)
+{
+  PROFILE_FUNCTION;
+  if (tileSize < 1) [[unlikely]]
+    throw std::invalid_argument(fmt::format("Invalid flow tile size ({} < 1)", tileSize));
+
+  if (ipc.GetRows() > imageSize.height or ipc.GetCols() > imageSize.width) [[unlikely]]
+    throw std::invalid_argument(fmt::format("Frames are too small ({} < {})", imageSize, cv::Size(ipc.GetCols(), ipc.GetRows())));
+
+  const bool float32 = ipc.GetPrecision() == IPC::Precision::Float32;
+  const bool shared = IsShared(ipc, spectra, 1);
+  const cv::Mat windowSpectrum = not ipc.GetRemoveMean() or not shared ? cv::Mat()
+                                 : float32                             ? CalculateWindowMaskSpectrum<float>(ipc)
+                                                                       : CalculateWindowMaskSpectrum<double>(ipc);
+  const cv::Size flowSize(resolution * imageSize.width, resolution * imageSize.height);
+  const int segmentsX = (flowSize.width + tileSize - 1) / tileSize;
+  const int segments = segmentsX * flowSize.height;
+  std::atomic<int> progress = 0;
+
+  // segments are scheduled dynamically, so segments without inside windows (image borders) do not stall the other threads
+  ParallelFor(segments,
+      [&](int segment)
+      {
+        const cv::Rect flowRect = cv::Rect(segment % segmentsX * tileSize, segment / segmentsX, tileSize, 1) & cv::Rect(cv::Point(0, 0), flowSize);
+        const cv::Rect imageRect = GetTileImageRect(ipc, imageSize, flowRect, resolution);
+        cv::Mat flowX = cv::Mat::zeros(flowRect.size(), GetMatType<IPC::Float>());
+        cv::Mat flowY = cv::Mat::zeros(flowRect.size(), GetMatType<IPC::Float>());
+        thread_local std::vector<cv::Mat> previous, current;
+        previous.clear(); // no spectra of the windows of the previous segment of this thread
+        current.clear();
+        cv::Mat image;
+
+        // the spectra of the previous frame are reused as image1 of this pair, the spectra of this frame become image1 of the next pair
+        for (int frame = 0; frame < frames; ++frame)
+        {
+          if (not imageRect.empty())
+          {
+            source(frame, imageRect, image);
+            if (image.size() != imageRect.size()) [[unlikely]]
+              throw std::invalid_argument(fmt::format("Invalid frame tile size ({} != {})", image.size(), imageRect.size()));
+
+            if (image.channels() != 1) [[unlikely]]
+              throw std::invalid_argument("Multichannel frames are not supported");
+
+            if (float32)
+              CalculateSegmentSpectra<float>(ipc, image, imageRect.tl(), imageSize, resolution, shared, windowSpectrum, flowRect, current);
+            else
+              CalculateSegmentSpectra<double>(ipc, image, imageRect.tl(), imageSize, resolution, shared, windowSpectrum, flowRect, current);
+
+            if (frame > 0)
+            {
+              if (float32)
+                CalculateSegmentPair<float>(ipc, shared, previous, current, flowX, flowY);
+              else
+                CalculateSegmentPair<double>(ipc, shared, previous, current, flowX, flowY);
+            }
+            std::swap(previous, current);
+          }
+
+          if (frame > 0)
+            sink(frame - 1, flowRect, flowX, flowY);
+        }
+
+        if (const int done = ++progress; done % std::max(segments / 20, 1) == 0)
+          LOG_DEBUG("Calculating IPC sequence flow ({:.0f}%)", static_cast<double>(done) / segments * 100);
+      });
+}
+
+std::vector<std::tuple<cv::Mat, cv::Mat>> IPCFlow::CalculateFlowSequence(const IPC& ipc, std::span<const cv::Mat> frames, double resolution, Spectra spectra)
+{
+  PROFILE_FUNCTION;
+  if (frames.size() < 2)
+    return {};
+
+  for (const auto& frame : frames)
+    if (frame.size() != frames.front().size()) [[unlikely]]
+      throw std::invalid_argument(fmt::format("Frame sizes differ ({} != {})", frame.size(), frames.front().size()));
+
+  const cv::Size flowSize(resolution * frames.front().cols, resolution * frames.front().rows);
+  std::vector<std::tuple<cv::Mat, cv::Mat>> flows(frames.size() - 1);
+  for (auto& [flowX, flowY] : flows)
   {
-    if (++progress % (flowX.rows / 20) == 0)
-      LOG_DEBUG("Calculating IPC flow profile ({:.0f}%)", static_cast<double>(progress) / flowX.rows * 100);
+    flowX.create(flowSize, GetMatType<IPC::Float>());
+    flowY.create(flowSize, GetMatType<IPC::Float>());
+  }
+
+  CalculateFlowSequenceTiled(
+      ipc, frames.front().size(), static_cast<int>(frames.size()), resolution, [&](int frame, const cv::Rect& rect, cv::Mat& image) { image = frames[frame](rect); },
+      [&](int pair, const cv::Rect& flowRect, const cv::Mat& tileX, const cv::Mat& tileY)
+      {
+        auto& [flowX, flowY] = flows[pair];
+        cv::Mat outX = flowX(flowRect), outY = flowY(flowRect); // ROI views write into the pair flows
+        tileX.copyTo(outX);
+        tileY.copyTo(outY);
+      },
+      kTileSize, spectra);
+  return flows;
+}
 
-    for (int c = 0; c < flowX.cols; ++c)
+void IPCFlow::CalculateFlowSequence(const IPC& ipc, const FrameSource& source, double resolution, const FlowSink& sink, Spectra spectra)
+{
+  PROFILE_FUNCTION;
+  std::vector<cv::Mat> chunk;
+  int pair = 0;
+  for (bool more = true; more;)
+  {
+    while (chunk.size() < kSequenceChunk and more)
     {
-      const cv::Point2i center(c / resolution, r / resolution);
+      more = source(chunk.emplace_back());
+      if (not more)
+        chunk.pop_back();
+    }
+
+    if (chunk.size() > 1)
+    {
+      LOG_DEBUG("Calculating IPC flow of frames {} - {}", pair, pair + chunk.size() - 1);
+      for (const auto& [flowX, flowY] : CalculateFlowSequence(ipc, chunk, resolution, spectra))
+        sink(pair++, flowX, flowY);
+    }
+
+    // the last frame of the chunk is image1 of the first pair of the next chunk
+    if (not chunk.empty())
+      chunk.erase(chunk.begin(), chunk.end() - 1);
+  }
+}
+
+std::tuple<cv::Mat, cv::Mat> IPCFlow::CalculateFlowAdaptive(
+    const IPC& ipc, const cv::Mat& image1, const cv::Mat& image2, double resolution, int step, double threshold, double minQuality)
+{
+  PROFILE_FUNCTION;
+  if (step < 1) [[unlikely]]
+    throw std::invalid_argument(fmt::format("Invalid adaptive flow step ({} < 1)", step));
+
+  if (image1.size() != image2.size()) [[unlikely]]
+    throw std::invalid_argument(fmt::format("Image sizes differ ({} != {})", image1.size(), image2.size()));
+
+  if (ipc.GetRows() > image1.rows or ipc.GetCols() > image1.cols) [[unlikely]]
+    throw std::invalid_argument(fmt::format("Images are too small ({} < {})", image1.size(), cv::Size(ipc.GetCols(), ipc.GetRows())));
+
+  const cv::Size flowSize(resolution * image1.cols, resolution * image1.rows);
+  cv::Mat flowX = cv::Mat::zeros(flowSize, GetMatType<IPC::Float>());
+  cv::Mat flowY = cv::Mat::zeros(flowSize, GetMatType<IPC::Float>());
+  cv::Mat nodes = cv::Mat::zeros(flowSize, CV_8U);
+  if (flowSize.empty())
+    return {flowX, flowY};
+
+  // coarse grid cells, the last cells of each row / column are clipped to the flow
+  std::vector<Cell> cells, next;
+  for (int y = 0; y == 0 or y < flowSize.height - 1; y += step)
+    for (int x = 0; x == 0 or x < flowSize.width - 1; x += step)
+      cells.push_back({{x, y}, {std::min(x + step, flowSize.width - 1), std::min(y + step, flowSize.height - 1)}});
+
+  const auto engine = CreateIPCEngine(ipc);
+  std::vector<cv::Point> queue;
+  std::atomic<uint64_t> registrations = 0; // IPC calls, out of bounds nodes are not registered
+  while (not cells.empty())
+  {
+    // the corners shared by several cells are registered once
+    queue.clear();
+    for (const auto& cell : cells)
+      for (const cv::Point corner : {cell.tl, cv::Point(cell.br.x, cell.tl.y), cv::Point(cell.tl.x, cell.br.y), cell.br})
+        if (auto& node = nodes.at<uchar>(corner); node == Unregistered)
+        {
+          node = Queued;
+          queue.push_back(corner);
+        }
+
+    ParallelFor(static_cast<int>(queue.size()),
+        [&](int idx)
+        {
+          const cv::Point node = queue[idx];
+          const cv::Point2i center(node.x / resolution, node.y / resolution);
+          if (IsOutOfBounds(ipc, center, image1.size()))
+          {
+            nodes.at<uchar>(node) = Unreliable;
+            return;
+          }
+
+          const auto window1 = RoiCropRef(image1, center.x, center.y, ipc.GetCols(), ipc.GetRows());
+          const auto window2 = RoiCropRef(image2, center.x, center.y, ipc.GetCols(), ipc.GetRows());
+          registrations.fetch_add(1, std::memory_order_relaxed);
+          IPC::Result result;
+          if (minQuality > 0)
+            result = engine->CalculateResult(window1, window2);
+          else
+            result.shift = engine->Calculate(window1, window2);
+
+          flowX.at<IPC::Float>(node) = result.shift.x;
+          flowY.at<IPC::Float>(node) = result.shift.y;
+          nodes.at<uchar>(node) = result.valid and (minQuality <= 0 or result.quality >= minQuality) ? Reliable : Unreliable;
+        });
+
+    // smooth cells are interpolated, the others are split into (up to) four cells, cells of adjacent nodes are complete
+    next.clear();
+    for (const auto& cell : cells)
+    {
+      if (cell.br.x - cell.tl.x <= 1 and cell.br.y - cell.tl.y <= 1)
+        continue;
 
-      if (IPC::IsOutOfBounds(center, image1, {ipc.mCols, ipc.mRows}))
+      if (IsSmoothCell(cell, flowX, flowY, nodes, threshold))
+      {
+        InterpolateCell(cell, flowX, flowY, nodes);
         continue;
+      }
 
-      const auto shift = ipc.Calculate(RoiCrop(image1, center.x, center.y, ipc.mCols, ipc.mRows), RoiCrop(image2, center.x, center.y, ipc.mCols, ipc.mRows));
-      flowX.at<IPC::Float>(r, c) = shift.x;
-      flowY.at<IPC::Float>(r, c) = shift.y;
+      const cv::Point mid((cell.tl.x + cell.br.x) / 2, (cell.tl.y + cell.br.y) / 2);
+      const auto xs = cell.br.x - cell.tl.x > 1 ? std::vector{std::pair{cell.tl.x, mid.x}, std::pair{mid.x, cell.br.x}} : std::vector{std::pair{cell.tl.x, cell.br.x}};
+      const auto ys = cell.br.y - cell.tl.y > 1 ? std::vector{std::pair{cell.tl.y, mid.y}, std::pair{mid.y, cell.br.y}} : std::vector{std::pair{cell.tl.y, cell.br.y}};
+      for (const auto& [y0, y1] : ys)
+        for (const auto& [x0, x1] : xs)
+          next.push_back({{x0, y0}, {x1, y1}});
     }
+    cells.swap(next);
   }
 
+  IPCStatistics::AddAdaptiveFlow(registrations.load(std::memory_order_relaxed), flowSize.area());
   return {flowX, flowY};
 }
-catch (const std::exception& e)
+
+void IPCFlow::CalculateFlowWindows(
+    const IPC& ipc, const cv::Mat& image1, const cv::Mat& image2, double resolution, cv::Mat& flowX, cv::Mat& flowY, const cv::Mat& priorX, const cv::Mat& priorY)
 {
-  LOG_EXCEPTION(e);
-  return {};
+  PROFILE_FUNCTION;
+  const auto engine = CreateIPCEngine(ipc);
+  std::atomic<int> progress = 0;
+
+  // flow rows are independent, each thread registers whole flow rows with its own IPC workspace
+  ParallelFor(flowX.rows,
+      [&](int r)
+      {
+        for (int c = 0; c < flowX.cols; ++c)
+        {
+          const cv::Point2i center(c / resolution, r / resolution);
+
+          if (IsOutOfBounds(ipc, center, image1.size()))
+            continue;
+
+          cv::Point2i offset(0, 0);
+          if (not priorX.empty())
+          {
+            offset.x = std::clamp<int>(std::round(priorX.at<IPC::Float>(r, c)), ipc.GetCols() / 2 - center.x, image2.cols - 1 - ipc.GetCols() / 2 - center.x);
+            offset.y = std::clamp<int>(std::round(priorY.at<IPC::Float>(r, c)), ipc.GetRows() / 2 - center.y, image2.rows - 1 - ipc.GetRows() / 2 - center.y);
+          }
+
+          // ROI views only, the IPC converts them to its floating point type directly
+          const auto shift = engine->Calculate(RoiCropRef(image1, center.x, center.y, ipc.GetCols(), ipc.GetRows()),
+              RoiCropRef(image2, center.x + offset.x, center.y + offset.y, ipc.GetCols(), ipc.GetRows()));
+          flowX.at<IPC::Float>(r, c) = offset.x + shift.x;
+          flowY.at<IPC::Float>(r, c) = offset.y + shift.y;
+        }
+
+        if (const int done = ++progress; done % std::max(flowX.rows / 20, 1) == 0)
+          LOG_DEBUG("Calculating IPC flow profile ({:.0f}%)", static_cast<double>(done) / flowX.rows * 100);
+      });
+}
+
+bool IPCFlow::IsShared(const IPC& ipc, Spectra spectra, int channels)
+{
+  return spectra == Spectra::Shared and channels == 1 and not ipc.GetHalfSpectrum();
+}
+
+cv::Rect IPCFlow::GetValidFlowRect(const IPC& ipc, const cv::Size& imageSize, const cv::Size& flowSize, double resolution)
+{
+  // the window bounds are separable, so the valid flow pixels form a rectangle
+  const auto range = [resolution](int flowSize, int window, int size)
+  {
+    int begin = flowSize, end = 0;
+    for (int index = 0; index < flowSize; ++index)
+    {
+      const int center = index / resolution;
+      if (center - window / 2 >= 0 and center + window / 2 < size)
+      {
+        begin = std::min(begin, index);
+        end = index + 1;
+      }
+    }
+    return std::pair{begin, std::max(begin, end)};
+  };
+
+  const auto [left, right] = range(flowSize.width, ipc.GetCols(), imageSize.width);
+  const auto [top, bottom] = range(flowSize.height, ipc.GetRows(), imageSize.height);
+  return cv::Rect(left, top, right - left, bottom - top);
+}
+
+cv::Rect IPCFlow::GetTileImageRect(const IPC& ipc, const cv::Size& imageSize, const cv::Rect& flowRect, double resolution)
+{
+  // windows outside of the images are not registered, so the region is clipped to the images
+  const int left = static_cast<int>(flowRect.x / resolution) - ipc.GetCols() / 2;
+  const int right = static_cast<int>((flowRect.br().x - 1) / resolution) - ipc.GetCols() / 2 + ipc.GetCols();
+  const int top = static_cast<int>(flowRect.y / resolution) - ipc.GetRows() / 2;
+  const int bottom = static_cast<int>((flowRect.br().y - 1) / resolution) - ipc.GetRows() / 2 + ipc.GetRows();
+  return cv::Rect(cv::Point(left, top), cv::Point(right, bottom)) & cv::Rect(cv::Point(0, 0), imageSize);
+}
+
+bool IPCFlow::IsOutOfBounds(const IPC& ipc, const cv::Point2i& center, const cv::Size& imageSize)
+{
+  return center.x - ipc.GetCols() / 2 < 0 or center.y - ipc.GetRows() / 2 < 0 or center.x + ipc.GetCols() / 2 >= imageSize.width or
+         center.y + ipc.GetRows() / 2 >= imageSize.height;
+}
+
+void IPCFlow::GetRowWindows(const IPC& ipc, const cv::Size& imageSize, const cv::Point2i& origin, double resolution, const cv::Rect& flowRect, int r,
+    std::vector<int>& cols, std::vector<int>& xs)
+{
+  cols.clear();
+  xs.clear();
+  for (int c = flowRect.x; c < flowRect.br().x; ++c)
+  {
+    const cv::Point2i center(c / resolution, r / resolution);
+    if (IsOutOfBounds(ipc, center, imageSize))
+      continue;
+
+    cols.push_back(c);
+    xs.push_back(center.x - ipc.GetCols() / 2 - origin.x);
+  }
+}
+
+bool IPCFlow::IsSmoothCell(const Cell& cell, const cv::Mat& flowX, const cv::Mat& flowY, const cv::Mat& nodes, double threshold)
+{
+  const std::array corners{cell.tl, cv::Point(cell.br.x, cell.tl.y), cv::Point(cell.tl.x, cell.br.y), cell.br};
+  for (const auto& flow : {&flowX, &flowY})
+  {
+    IPC::Float min = std::numeric_limits<IPC::Float>::max(), max = std::numeric_limits<IPC::Float>::lowest();
+    for (const auto& corner : corners)
+    {
+      if (nodes.at<uchar>(corner) != Reliable)
+        return false;
+      min = std::min(min, flow->at<IPC::Float>(corner));
+      max = std::max(max, flow->at<IPC::Float>(corner));
+    }
+    if (max - min > threshold)
+      return false;
+  }
+  return true;
+}
+
+void IPCFlow::InterpolateCell(const Cell& cell, cv::Mat& flowX, cv::Mat& flowY, const cv::Mat& nodes)
+{
+  const double width = std::max(cell.br.x - cell.tl.x, 1);
+  const double height = std::max(cell.br.y - cell.tl.y, 1);
+  for (auto flow : {&flowX, &flowY})
+  {
+    const IPC::Float tl = flow->at<IPC::Float>(cell.tl), tr = flow->at<IPC::Float>(cell.tl.y, cell.br.x);
+    const IPC::Float bl = flow->at<IPC::Float>(cell.br.y, cell.tl.x), br = flow->at<IPC::Float>(cell.br);
+    for (int y = cell.tl.y; y <= cell.br.y; ++y)
+    {
+      const double ty = (y - cell.tl.y) / height;
+      const auto nodesp = nodes.ptr<uchar>(y);
+      auto flowp = flow->ptr<IPC::Float>(y);
+      for (int x = cell.tl.x; x <= cell.br.x; ++x)
+      {
+        // registered nodes on the cell edges (hanging nodes of finer neighbors) keep their flow
+        if (nodesp[x] != Unregistered)
+          continue;
+
+        const double tx = (x - cell.tl.x) / width;
+        flowp[x] = (1 - ty) * ((1 - tx) * tl + tx * tr) + ty * ((1 - tx) * bl + tx * br);
+      }
+    }
+  }
+}
+
+void IPCFlow::CalculateTileWindows(const IPCEngine& engine, const cv::Mat& image1, const cv::Mat& image2, const cv::Point2i& origin, const cv::Size& imageSize,
+    double resolution, const cv::Rect& flowRect, cv::Mat& flowX, cv::Mat& flowY)
+{
+  PROFILE_FUNCTION;
+  const IPC& ipc = engine.GetIPC();
+  for (int r = flowRect.y; r < flowRect.br().y; ++r)
+    for (int c = flowRect.x; c < flowRect.br().x; ++c)
+    {
+      const cv::Point2i center(c / resolution, r / resolution);
+      if (IsOutOfBounds(ipc, center, imageSize))
+        continue;
+
+      const cv::Point2i local = center - origin;
+      const auto shift = engine.Calculate(RoiCropRef(image1, local.x, local.y, ipc.GetCols(), ipc.GetRows()), RoiCropRef(image2, local.x, local.y, ipc.GetCols(), ipc.GetRows()));
+      flowX.at<IPC::Float>(r - flowRect.y, c - flowRect.x) = shift.x;
+      flowY.at<IPC::Float>(r - flowRect.y, c - flowRect.x) = shift.y;
+    }
+}
+
+// the windowed DFT of a window at (x, y) is separable: the row-windowed column DFTs of the image columns x..x+cols-1 over the image rows y..y+rows-1
+// are shared by all windows of the flow row and the window only applies the column window and the row DFTs, the spectra of real windows are
+// Hermitian, so only the rows 0..rows/2 are transformed and the rest is mirrored, the window mean is removed in the spectral domain as
+// DFT((image - mean) * window) = DFT(image * window) - mean * DFT(window)
+template <typename T>
+void IPCFlow::CalculateFlowShared(const IPC& ipc, const cv::Mat& image1, const cv::Mat& image2, double resolution, cv::Mat& flowX, cv::Mat& flowY)
+{
+  PROFILE_FUNCTION;
+  const cv::Mat windowSpectrum = ipc.GetRemoveMean() ? CalculateWindowMaskSpectrum<T>(ipc) : cv::Mat();
+  const cv::Rect flowRect(0, 0, flowX.cols, flowX.rows);
+  std::atomic<int> progress = 0;
+
+  // flow rows are independent, each thread registers whole flow rows with its own band & IPC workspace
+  ParallelFor(flowX.rows,
+      [&](int r)
+      {
+        CalculateFlowRow<T>(ipc, image1, image2, {0, 0}, image1.size(), resolution, windowSpectrum, flowRect, r, flowX, flowY);
+
+        if (const int done = ++progress; done % std::max(flowX.rows / 20, 1) == 0)
+          LOG_DEBUG("Calculating IPC flow profile ({:.0f}%)", static_cast<double>(done) / flowX.rows * 100);
+      });
+}
+
+template <typename T>
+void IPCFlow::CalculateFlowRow(const IPC& ipc, const cv::Mat& image1, const cv::Mat& image2, const cv::Point2i& origin, const cv::Size& imageSize,
+    double resolution, const cv::Mat& windowSpectrum, const cv::Rect& flowRect, int r, cv::Mat& flowX, cv::Mat& flowY)
+{
+  thread_local std::vector<int> cols, xs;
+  GetRowWindows(ipc, imageSize, origin, resolution, flowRect, r, cols, xs);
+  if (cols.empty())
+    return;
+
+  // all windows of the flow row cover the same image rows
+  const cv::Rect rect(xs.front(), static_cast<int>(r / resolution) - ipc.GetRows() / 2 - origin.y, xs.back() - xs.front() + ipc.GetCols(), ipc.GetRows());
+  thread_local Band band1, band2;
+  thread_local cv::Mat rows;
+  CalculateBand<T>(ipc, image1, rect, band1);
+  CalculateBand<T>(ipc, image2, rect, band2);
+
+  auto& workspace = IPC::GetThreadWorkspace();
+  for (size_t idx = 0; idx < cols.size(); ++idx)
+  {
+    CalculateWindowSpectrum<T>(ipc, band1, xs[idx] - rect.x, windowSpectrum, rows, workspace.dft1);
+    CalculateWindowSpectrum<T>(ipc, band2, xs[idx] - rect.x, windowSpectrum, rows, workspace.dft2);
+    const auto shift = ipc.CalculateFromSpectra(workspace.dft1, workspace.dft2, workspace);
+    flowX.at<IPC::Float>(r - flowRect.y, cols[idx] - flowRect.x) = shift.x;
+    flowY.at<IPC::Float>(r - flowRect.y, cols[idx] - flowRect.x) = shift.y;
+  }
+}
+
+template <typename T>
+void IPCFlow::CalculateSegmentSpectra(const IPC& ipc, const cv::Mat& image, const cv::Point2i& origin, const cv::Size& imageSize, double resolution,
+    bool shared, const cv::Mat& windowSpectrum, const cv::Rect& flowRect, std::vector<cv::Mat>& spectra)
+{
+  PROFILE_FUNCTION;
+  thread_local std::vector<int> cols, xs;
+  GetRowWindows(ipc, imageSize, origin, resolution, flowRect, flowRect.y, cols, xs);
+  spectra.resize(flowRect.width);
+  if (cols.empty())
+    return;
+
+  // all windows of the segment cover the same image rows
+  const int y = static_cast<int>(flowRect.y / resolution) - ipc.GetRows() / 2 - origin.y;
+
+  // separately transformed windows keep the IPC reference spectra
+  if (not shared)
+  {
+    for (size_t idx = 0; idx < cols.size(); ++idx)
+      spectra[cols[idx] - flowRect.x] = ipc.PrepareReference(image(cv::Rect(xs[idx], y, ipc.GetCols(), ipc.GetRows()))).dft;
+    return;
+  }
+
+  const cv::Rect rect(xs.front(), y, xs.back() - xs.front() + ipc.GetCols(), ipc.GetRows());
+  const int halfRows = ipc.GetDFTSize().height / 2 + 1;
+  thread_local Band band;
+  thread_local cv::Mat rows;
+  CalculateBand<T>(ipc, image, rect, band);
+  for (size_t idx = 0; idx < cols.size(); ++idx)
+  {
+    cv::Mat& half = spectra[cols[idx] - flowRect.x];
+    half.create(halfRows, ipc.GetDFTSize().width, GetMatType<T>(2));
+    CalculateWindowHalfSpectrum<T>(ipc, band, xs[idx] - rect.x, windowSpectrum, rows, half);
+  }
+}
+
+template <typename T>
+void IPCFlow::CalculateSegmentPair(
+    const IPC& ipc, bool shared, const std::vector<cv::Mat>& spectra1, const std::vector<cv::Mat>& spectra2, cv::Mat& flowX, cv::Mat& flowY)
+{
+  PROFILE_FUNCTION;
+  auto& workspace = IPC::GetThreadWorkspace();
+  for (int c = 0; c < flowX.cols; ++c)
+  {
+    const cv::Mat& spectrum1 = spectra1[c];
+    const cv::Mat& spectrum2 = spectra2[c];
+    if (spectrum1.empty())
+      continue;
+
+    // the cached spectra are immutable, the cross-power spectrum is computed in place of the workspace copy of spectrum2
+    if (not shared)
+      spectrum2.copyTo(workspace.dft2);
+    else
+    {
+      for (auto [spectrum, dft] : {std::pair{&spectrum1, &workspace.dft1}, std::pair{&spectrum2, &workspace.dft2}})
+      {
+        dft->create(ipc.GetDFTSize(), GetMatType<T>(2));
+        cv::Mat half = dft->rowRange(0, spectrum->rows);
+        spectrum->copyTo(half);
+        MirrorSpectrum<T>(*dft);
+      }
+    }
+
+    const auto shift = ipc.CalculateFromSpectra(shared ? workspace.dft1 : spectrum1, workspace.dft2, workspace);
+    flowX.at<IPC::Float>(0, c) = shift.x;
+    flowY.at<IPC::Float>(0, c) = shift.y;
+  }
+}
+
+template <typename T>
+void IPCFlow::CalculateBand(const IPC& ipc, const cv::Mat& image, const cv::Rect& rect, Band& band)
+{
+  PROFILE_FUNCTION;
+  const cv::Size size = ipc.GetDFTSize();
+  const bool window = ipc.GetWindowType() != IPC::WindowType::None;
+  thread_local cv::Mat converted, transposed, spectra;
+
+  // each image column of the band becomes a row of the transposed band, which is row-windowed and zero-padded to the DFT rows, the prefix sums of
+  // the image column sums are accumulated on the way
+  image(rect).convertTo(converted, GetMatType<T>());
+  transposed.create(rect.width, size.height, GetMatType<T>());
+  band.sums.assign(rect.width + 1, 0.);
+  for (int col = 0; col < rect.width; ++col)
+  {
+    auto transposedp = transposed.ptr<T>(col);
+    double sum = 0;
+    for (int row = 0; row < rect.height; ++row)
+    {
+      const T value = converted.at<T>(row, col);
+      transposedp[row] = window ? value * static_cast<T>(ipc.GetWindowRowProfile()[row]) : value;
+      sum += value;
+    }
+    std::fill(transposedp + rect.height, transposedp + size.height, T(0));
+    band.sums[col + 1] = band.sums[col] + sum;
+  }
+
+  RowFFT(transposed, spectra);
+  cv::transpose(spectra.colRange(0, size.height / 2 + 1), band.columns);
+}
+
+template <typename T>
+void IPCFlow::CalculateWindowSpectrum(const IPC& ipc, const Band& band, int x, const cv::Mat& windowSpectrum, cv::Mat& rows, cv::Mat& spectrum)
+{
+  spectrum.create(ipc.GetDFTSize(), GetMatType<T>(2));
+  cv::Mat half = spectrum.rowRange(0, spectrum.rows / 2 + 1);
+  CalculateWindowHalfSpectrum<T>(ipc, band, x, windowSpectrum, rows, half);
+  MirrorSpectrum<T>(spectrum);
+}
+
+template <typename T>
+void IPCFlow::CalculateWindowHalfSpectrum(const IPC& ipc, const Band& band, int x, const cv::Mat& windowSpectrum, cv::Mat& rows, cv::Mat& half)
+{
+  PROFILE_FUNCTION;
+  const cv::Size size = ipc.GetDFTSize();
+  const int halfRows = size.height / 2 + 1;
+  const bool window = ipc.GetWindowType() != IPC::WindowType::None;
+
+  // column-windowed band columns of the window, the zero-padding columns are only cleared on allocation
+  if (rows.rows != halfRows or rows.cols != size.width or rows.type() != GetMatType<T>(2))
+    rows = cv::Mat::zeros(halfRows, size.width, GetMatType<T>(2));
+
+  for (int row = 0; row < halfRows; ++row)
+  {
+    const auto columnsp = band.columns.ptr<cv::Vec<T, 2>>(row) + x;
+    auto rowsp = rows.ptr<cv::Vec<T, 2>>(row);
+    for (int col = 0; col < ipc.GetCols(); ++col)
+    {
+      const T colWindow = window ? static_cast<T>(ipc.GetWindowColProfile()[col]) : T(1);
+      rowsp[col] = {columnsp[col][0] * colWindow, columnsp[col][1] * colWindow};
+    }
+  }
+
+  RowFFT(rows, half);
+
+  if (ipc.GetRemoveMean())
+  {
+    const double mean = (band.sums[x + ipc.GetCols()] - band.sums[x]) / (static_cast<double>(ipc.GetRows()) * ipc.GetCols());
+    cv::scaleAdd(windowSpectrum.rowRange(0, halfRows), -mean, half, half);
+  }
+}
+
+// Hermitian symmetry F(-r, -c) = conj(F(r, c)) of the spectra of real windows
+template <typename T>
+void IPCFlow::MirrorSpectrum(cv::Mat& spectrum)
+{
+  for (int row = spectrum.rows / 2 + 1; row < spectrum.rows; ++row)
+  {
+    auto spectrump = spectrum.ptr<cv::Vec<T, 2>>(row);
+    const auto mirrorp = spectrum.ptr<cv::Vec<T, 2>>(spectrum.rows - row);
+    for (int col = 0; col < spectrum.cols; ++col)
+    {
+      const auto& mirror = mirrorp[(spectrum.cols - col) % spectrum.cols];
+      spectrump[col] = {mirror[0], -mirror[1]};
+    }
+  }
+}
+
+// DFT of the (zero-padded) window mask
+template <typename T>
+cv::Mat IPCFlow::CalculateWindowMaskSpectrum(const IPC& ipc)
+{
+  const bool window = ipc.GetWindowType() != IPC::WindowType::None;
+  cv::Mat mask = cv::Mat::zeros(ipc.GetDFTSize(), GetMatType<T>());
+  for (int row = 0; row < ipc.GetRows(); ++row)
+    for (int col = 0; col < ipc.GetCols(); ++col)
+      mask.at<T>(row, col) = window ? static_cast<T>(ipc.GetWindowRowProfile()[row] * ipc.GetWindowColProfile()[col]) : T(1);
+
+  return FFT(std::move(mask));
 }
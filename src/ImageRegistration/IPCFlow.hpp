@@ -1,10 +1,170 @@
 #pragma once
 
 class IPC;
+class IPCEngine;
 
+// invalid inputs (image, frame or tile sizes, flow parameters) throw std::invalid_argument from all entry points, same as IPC::Calculate
 class IPCFlow
 {
 public:
-  static std::tuple<cv::Mat, cv::Mat> CalculateFlow(const IPC& ipc, const cv::Mat& image1, const cv::Mat& image2, double resolution);
-  static std::tuple<cv::Mat, cv::Mat> CalculateFlow(const IPC& ipc, cv::Mat&& image1, cv::Mat&& image2, double resolution);
+  // loads the image region rect of both images (ROI views or copies of the rect size)
+  using TileSource = std::function<void(const cv::Rect& rect, cv::Mat& image1, cv::Mat& image2)>;
+  // receives the flow of the flow pixels in flowRect, called concurrently from the worker threads for disjoint flow rects
+  using TileSink = std::function<void(const cv::Rect& flowRect, const cv::Mat& flowX, const cv::Mat& flowY)>;
+
+  // reads the next frame of a sequence into a new frame, returns false after the last frame (frames are kept until their chunk is registered)
+  using FrameSource = std::function<bool(cv::Mat& frame)>;
+  // receives the flow between the frames pair and pair + 1
+  using FlowSink = std::function<void(int pair, const cv::Mat& flowX, const cv::Mat& flowY)>;
+
+  // loads the image region rect of a sequence frame (ROI view or copy of the rect size), the frames of each region are requested in order
+  using SequenceTileSource = std::function<void(int frame, const cv::Rect& rect, cv::Mat& image)>;
+  // receives the flow of the flow pixels in flowRect between the frames pair and pair + 1, called concurrently for disjoint flow rects
+  using SequenceTileSink = std::function<void(int pair, const cv::Rect& flowRect, const cv::Mat& flowX, const cv::Mat& flowY)>;
+
+  // window spectra of the dense flows
+  enum class Spectra : uint8_t
+  {
+    PerWindow,   // each pair of windows is transformed & registered separately, identical to calling IPC::Calculate for each pair of windows
+    Shared,      // the window spectra of single channel images are assembled from DFTs shared between overlapping windows, equal up to rounding
+    SpectraCount // last
+  };
+
+  static constexpr int kTileSize = 64;     // default flow tile size in flow pixels
+  static constexpr int kAdaptiveStep = 8;  // default coarse grid step of the adaptive flow in flow pixels
+  static constexpr int kSequenceChunk = 8; // frames of an ordered frame source registered at once by the sequence flow
+
+  // dense optical flow, the subpixel shift of the IPC-sized windows centered at every 1 / resolution pixels (out of bounds flow pixels are zero)
+  static std::tuple<cv::Mat, cv::Mat> CalculateFlow(const IPC& ipc, const cv::Mat& image1, const cv::Mat& image2, double resolution, Spectra spectra = Spectra::PerWindow);
+  static std::tuple<cv::Mat, cv::Mat> CalculateFlow(const IPC& ipc, cv::Mat&& image1, cv::Mat&& image2, double resolution, Spectra spectra = Spectra::PerWindow);
+
+  // coarse-to-fine dense optical flow for large motions with small windows, the flow of the images downsampled 2^levels times is upsampled as the prior
+  // of the next finer level, where the IPC-sized windows of image2 are pre-shifted by the prior so that only the residual motion is registered
+  // (levels = 0 is CalculateFlow)
+  static std::tuple<cv::Mat, cv::Mat> CalculateFlowPyramid(const IPC& ipc, const cv::Mat& image1, const cv::Mat& image2, double resolution, int levels);
+
+  // CalculateFlow over square flow tiles scheduled dynamically over the threads, each tile only loads the image region covered by its windows and
+  // streams its flow to the sink, so the memory is bounded by the tiles in flight (the output matches CalculateFlow with the same spectra)
+  static void CalculateFlowTiled(const IPC& ipc, const cv::Size& imageSize, double resolution, const TileSource& source, const TileSink& sink, int tileSize = kTileSize,
+      Spectra spectra = Spectra::PerWindow);
+
+  // tiled flow of in-memory images written into flowX / flowY, which are allocated if empty and otherwise have to be preallocated with the flow size
+  // and type (e.g. headers of memory-mapped buffers), they are written in place and never reallocated
+  static void CalculateFlowTiled(const IPC& ipc, const cv::Mat& image1, const cv::Mat& image2, double resolution, cv::Mat& flowX, cv::Mat& flowY, int tileSize = kTileSize,
+      Spectra spectra = Spectra::PerWindow);
+
+  // flow between all consecutive frames of a single channel frame sequence, the flow rows are split into segments of tileSize flow pixels scheduled
+  // dynamically over the threads, each segment walks the frames in order and keeps the window spectra of its previous frame for exactly one step, so
+  // every frame is transformed once instead of once per pair while the memory is bounded by the segments in flight (the outputs match
+  // CalculateFlowTiled of the pairs with the same tile size & spectra)
+  static void CalculateFlowSequenceTiled(const IPC& ipc, const cv::Size& imageSize, int frames, double resolution, const SequenceTileSource& source,
+      const SequenceTileSink& sink, int tileSize = kTileSize, Spectra spectra = Spectra::PerWindow);
+
+  // tiled sequence flow of in-memory frames
+  static std::vector<std::tuple<cv::Mat, cv::Mat>> CalculateFlowSequence(
+      const IPC& ipc, std::span<const cv::Mat> frames, double resolution, Spectra spectra = Spectra::PerWindow);
+
+  // tiled sequence flow of an ordered frame source read in chunks of kSequenceChunk frames, the last frame of each chunk starts the next one (and is
+  // transformed once more), so only the frames of one chunk are held in memory
+  static void CalculateFlowSequence(const IPC& ipc, const FrameSource& source, double resolution, const FlowSink& sink, Spectra spectra = Spectra::PerWindow);
+
+  // adaptive sparse flow, the IPC windows are registered at the nodes of a coarse grid with the given step (in flow pixels), grid cells whose corner
+  // flows differ by more than threshold pixels or whose corners are unreliable (outside of the images or peak quality below minQuality) are split in
+  // quadtree fashion and the remaining cells are bilinearly interpolated from their corners (step = 1 registers every flow pixel with the same IPC engine
+  // as CalculateFlow with the per-window spectra)
+  static std::tuple<cv::Mat, cv::Mat> CalculateFlowAdaptive(const IPC& ipc, const cv::Mat& image1, const cv::Mat& image2, double resolution,
+      int step = kAdaptiveStep, double threshold = 0.25, double minQuality = 0);
+
+private:
+  // registration state of the adaptive flow nodes
+  enum NodeState : uint8_t
+  {
+    Unregistered, // interpolated or not yet visited
+    Queued,       // scheduled for registration in the current refinement level
+    Reliable,     // registered with sufficient peak quality
+    Unreliable,   // outside of the images or registered with low peak quality
+  };
+
+  // adaptive flow grid cell given by its (inclusive) corner nodes
+  struct Cell
+  {
+    cv::Point tl;
+    cv::Point br;
+  };
+
+  // windowed column DFTs of the image band covered by all windows of one flow row
+  struct Band
+  {
+    cv::Mat columns;          // non-redundant half of the row-windowed & zero-padded column DFTs, one column per image column of the band
+    std::vector<double> sums; // prefix sums of the image column sums of the band (for the window means)
+  };
+
+  // flow rows are registered in parallel with independent IPC calls of their windows, the image2 windows are pre-shifted by the rounded prior flow
+  // (if any, kept inside image2) which is added back to the registered shifts
+  static void CalculateFlowWindows(const IPC& ipc, const cv::Mat& image1, const cv::Mat& image2, double resolution, cv::Mat& flowX, cv::Mat& flowY,
+      const cv::Mat& priorX = cv::Mat(), const cv::Mat& priorY = cv::Mat());
+
+  // the shared spectra are assembled in the full complex layout of single channel images
+  static bool IsShared(const IPC& ipc, Spectra spectra, int channels);
+
+  // flow pixels whose windows lie inside the images
+  static cv::Rect GetValidFlowRect(const IPC& ipc, const cv::Size& imageSize, const cv::Size& flowSize, double resolution);
+
+  // image region covered by the inside windows of the flow pixels in flowRect
+  static cv::Rect GetTileImageRect(const IPC& ipc, const cv::Size& imageSize, const cv::Rect& flowRect, double resolution);
+
+  static bool IsOutOfBounds(const IPC& ipc, const cv::Point2i& center, const cv::Size& imageSize);
+
+  // true if the corners of the cell are reliable and their flows differ by at most threshold pixels
+  static bool IsSmoothCell(const Cell& cell, const cv::Mat& flowX, const cv::Mat& flowY, const cv::Mat& nodes, double threshold);
+
+  // bilinear interpolation of the unregistered flow pixels of the cell from its corners
+  static void InterpolateCell(const Cell& cell, cv::Mat& flowX, cv::Mat& flowY, const cv::Mat& nodes);
+
+  // flow pixels cols of flow row r of flowRect whose windows lie inside the images and the left image columns xs of their windows relative to origin
+  static void GetRowWindows(const IPC& ipc, const cv::Size& imageSize, const cv::Point2i& origin, double resolution, const cv::Rect& flowRect, int r,
+      std::vector<int>& cols, std::vector<int>& xs);
+
+  // flow of the flow pixels in flowRect from the image tiles whose top-left pixel is origin in the full images, each window is registered separately
+  static void CalculateTileWindows(const IPCEngine& engine, const cv::Mat& image1, const cv::Mat& image2, const cv::Point2i& origin, const cv::Size& imageSize,
+      double resolution, const cv::Rect& flowRect, cv::Mat& flowX, cv::Mat& flowY);
+
+  // window spectra of each flow row are assembled from the shared band column DFTs, each window only computes the row DFTs of the non-redundant
+  // half of its Hermitian spectrum
+  template <typename T>
+  static void CalculateFlowShared(const IPC& ipc, const cv::Mat& image1, const cv::Mat& image2, double resolution, cv::Mat& flowX, cv::Mat& flowY);
+
+  // shared flow of flow row r of flowRect (flowX / flowY cover flowRect) from the image tiles whose top-left pixel is origin in the full images
+  template <typename T>
+  static void CalculateFlowRow(const IPC& ipc, const cv::Mat& image1, const cv::Mat& image2, const cv::Point2i& origin, const cv::Size& imageSize,
+      double resolution, const cv::Mat& windowSpectrum, const cv::Rect& flowRect, int r, cv::Mat& flowX, cv::Mat& flowY);
+
+  template <typename T>
+  static void CalculateBand(const IPC& ipc, const cv::Mat& image, const cv::Rect& rect, Band& band);
+
+  // window spectra of the flow row segment flowRect (a single flow row) of a sequence frame tile whose top-left pixel is origin in the full frames, one
+  // per flow pixel of the segment (empty outside of the frames), the non-redundant rows of the shared spectra or the IPC reference spectra of the
+  // separately transformed windows
+  template <typename T>
+  static void CalculateSegmentSpectra(const IPC& ipc, const cv::Mat& image, const cv::Point2i& origin, const cv::Size& imageSize, double resolution,
+      bool shared, const cv::Mat& windowSpectrum, const cv::Rect& flowRect, std::vector<cv::Mat>& spectra);
+
+  // flow of a flow row segment between two frames from their segment spectra
+  template <typename T>
+  static void CalculateSegmentPair(
+      const IPC& ipc, bool shared, const std::vector<cv::Mat>& spectra1, const std::vector<cv::Mat>& spectra2, cv::Mat& flowX, cv::Mat& flowY);
+
+  template <typename T>
+  static void CalculateWindowSpectrum(const IPC& ipc, const Band& band, int x, const cv::Mat& windowSpectrum, cv::Mat& rows, cv::Mat& spectrum);
+
+  // rows 0..rows/2 of the window spectrum into the preallocated half
+  template <typename T>
+  static void CalculateWindowHalfSpectrum(const IPC& ipc, const Band& band, int x, const cv::Mat& windowSpectrum, cv::Mat& rows, cv::Mat& half);
+
+  // fills rows rows/2+1.. of a window spectrum from its rows 0..rows/2
+  template <typename T>
+  static void MirrorSpectrum(cv::Mat& spectrum);
+
+  template <typename T>
+  static cv::Mat CalculateWindowMaskSpectrum(const IPC& ipc);
 };
@@ -0,0 +1,81 @@
+#pragma once
+
+// process-wide thread-safe cache of the IPC window, bandpass, L1 window masks and DFT kernels keyed by (mask, size, type, parameters), so that constructing many IPC
+// instances with the same parameters (e.g. during parameter optimization) is nearly free, cached masks are shared between instances and must not be modified
+class IPCMaskCache
+{
+public:
+  enum class Mask : uint8_t
+  {
+    Window,
+    Bandpass,
+    L1Window,
+    DFTGridKernel,
+  };
+
+  using Key = std::tuple<Mask, int, int, int, int, double, double>; // mask, mask type, rows, cols, mat type, parameter 1, parameter 2
+
+  // get the cached mask or create (outside of the lock) and cache it
+  static cv::Mat Get(const Key& key, const std::function<cv::Mat()>& create)
+  {
+    auto& cache = Instance();
+    {
+      std::scoped_lock lock(cache.mMutex);
+      if (const auto it = cache.mMasks.find(key); it != cache.mMasks.end())
+      {
+        cache.mEntries.splice(cache.mEntries.begin(), cache.mEntries, it->second); // mark as most recently used
+        return it->second->second;
+      }
+    }
+
+    cv::Mat mask = create();
+    std::scoped_lock lock(cache.mMutex);
+    if (const auto it = cache.mMasks.find(key); it != cache.mMasks.end()) // created concurrently by another thread
+      return it->second->second;
+
+    cache.mEntries.emplace_front(key, mask);
+    cache.mMasks[key] = cache.mEntries.begin();
+    cache.mBytes += GetBytes(mask);
+
+    // evict the least recently used masks, masks still held by IPC instances stay alive through their reference count
+    while (cache.mBytes > kCapacityBytes and cache.mEntries.size() > 1)
+    {
+      cache.mBytes -= GetBytes(cache.mEntries.back().second);
+      cache.mMasks.erase(cache.mEntries.back().first);
+      cache.mEntries.pop_back();
+    }
+    return mask;
+  }
+
+  static size_t Size()
+  {
+    auto& cache = Instance();
+    std::scoped_lock lock(cache.mMutex);
+    return cache.mEntries.size();
+  }
+
+  static void Clear()
+  {
+    auto& cache = Instance();
+    std::scoped_lock lock(cache.mMutex);
+    cache.mMasks.clear();
+    cache.mEntries.clear();
+    cache.mBytes = 0;
+  }
+
+private:
+  static constexpr size_t kCapacityBytes = 256 * 1024 * 1024;
+
+  std::mutex mMutex;
+  std::list<std::pair<Key, cv::Mat>> mEntries; // most recently used first
+  std::map<Key, std::list<std::pair<Key, cv::Mat>>::iterator> mMasks;
+  size_t mBytes = 0;
+
+  static IPCMaskCache& Instance()
+  {
+    static IPCMaskCache cache;
+    return cache;
+  }
+
+  static size_t GetBytes(const cv::Mat& mask) { return mask.total() * mask.elemSize(); }
+};
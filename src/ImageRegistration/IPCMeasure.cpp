@@ -1,5 +1,7 @@
 #include "IPCMeasure.hpp"
 #include "IPC.hpp"
+#include "IPCPyramid.hpp"
+#include "IPCStatic.hpp"
 #include "CrossCorrelation.hpp"
 #include "PhaseCorrelation.hpp"
 #include "PhaseCorrelationUpscale.hpp"
@@ -20,6 +22,27 @@ void IPCMeasure::MeasureAccuracy(const IPC& ipc, const IPC& ipcopt, const std::s
   cv::Mat accuracyPCS = cv::Mat::zeros(iters, iters, GetMatType<double>());
   cv::Mat accuracyIPC = cv::Mat::zeros(iters, iters, GetMatType<double>());
   cv::Mat accuracyIPCO = cv::Mat::zeros(iters, iters, GetMatType<double>());
+  cv::Mat accuracyIPCP = cv::Mat::zeros(iters, iters, GetMatType<double>());
+
+  std::vector<cv::Mat> images1, images2;
+  images1.reserve(dataset.imagePairs.size());
+  images2.reserve(dataset.imagePairs.size());
+  for (const auto& imagePair : dataset.imagePairs)
+  {
+    images1.push_back(imagePair.image1);
+    images2.push_back(imagePair.image2);
+  }
+  const auto timed = [](auto&& calculate)
+  {
+    const auto start = std::chrono::steady_clock::now();
+    auto shifts = calculate();
+    return std::pair{std::move(shifts), std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count()};
+  };
+  const IPCPyramid ipcp(ipc, mPyramidLevels, std::max(ipc.GetRows(), ipc.GetCols()) * mPyramidRefinementRatio);
+  const auto engine = CreateIPCEngine(ipc);
+  const auto [shiftsIPC, timeIPC] = timed([&]() { return engine->CalculateBatch(images1, images2); });
+  const auto shiftsIPCO = CreateIPCEngine(ipcopt)->CalculateBatch(images1, images2);
+  const auto [shiftsIPCP, timeIPCP] = timed([&]() { return ipcp.CalculateBatch(images1, images2); });
 
   std::atomic<size_t> iprogress = 0;
 #pragma omp parallel for
@@ -35,8 +58,9 @@ void IPCMeasure::MeasureAccuracy(const IPC& ipc, const IPC& ipcopt, const std::s
     refShiftsY.at<double>(row, col) = shift.y;
     accuracyPC.at<double>(row, col) += Magnitude(PhaseCorrelation::Calculate(image1, image2) - shift);
     accuracyPCS.at<double>(row, col) += Magnitude(cv::phaseCorrelate(image1, image2) - shift);
-    accuracyIPC.at<double>(row, col) += Magnitude(ipc.Calculate(image1, image2) - shift);
-    accuracyIPCO.at<double>(row, col) += Magnitude(ipcopt.Calculate(image1, image2) - shift);
+    accuracyIPC.at<double>(row, col) += Magnitude(shiftsIPC[idx] - shift);
+    accuracyIPCO.at<double>(row, col) += Magnitude(shiftsIPCO[idx] - shift);
+    accuracyIPCP.at<double>(row, col) += Magnitude(shiftsIPCP[idx] - shift);
 
     if (idx == 0)
     {
@@ -61,12 +85,16 @@ void IPCMeasure::MeasureAccuracy(const IPC& ipc, const IPC& ipcopt, const std::s
     accuracyPCS = QuantileFilter<double>(accuracyPCS / dataset.imageCount, 0, mQuanT);
     accuracyIPC = QuantileFilter<double>(accuracyIPC / dataset.imageCount, 0, mQuanT);
     accuracyIPCO = QuantileFilter<double>(accuracyIPCO / dataset.imageCount, 0, mQuanT);
+    accuracyIPCP = QuantileFilter<double>(accuracyIPCP / dataset.imageCount, 0, mQuanT);
   }
 
   LOG_INFO("PC average accuracy: {:.3f} ± {:.3f}", Mean<double>(accuracyPC), Stddev<double>(accuracyPC));
   LOG_INFO("PCS average accuracy: {:.3f} ± {:.3f}", Mean<double>(accuracyPCS), Stddev<double>(accuracyPCS));
   LOG_INFO("IPC average accuracy: {:.3f} ± {:.3f}", Mean<double>(accuracyIPC), Stddev<double>(accuracyIPC));
   LOG_INFO("IPCO average accuracy: {:.3f} ± {:.3f}", Mean<double>(accuracyIPCO), Stddev<double>(accuracyIPCO));
+  LOG_INFO("IPCP average accuracy: {:.3f} ± {:.3f}", Mean<double>(accuracyIPCP), Stddev<double>(accuracyIPCP));
+  LOG_INFO("IPCP speedup: {:.2f}x ({:.1f} ms -> {:.1f} ms, {} levels, {}x{} refinement window)", timeIPC / timeIPCP, timeIPC, timeIPCP, ipcp.GetLevels(),
+      ipcp.GetIPC(0).GetCols(), ipcp.GetIPC(0).GetRows());
 
   // PyPlot::PlotCustom(
   //     "imreg_accuracy", py::dict{"name"_a = "shift error", "x"_a = ColMeans<double>(refShiftsX), "pc_error"_a = ColMeans<double>(accuracyPC), "pc_stddev"_a =
@@ -77,8 +105,8 @@ void IPCMeasure::MeasureAccuracy(const IPC& ipc, const IPC& ipcopt, const std::s
 
   Plot::Plot({.name = "shift error",
       .x = ColMeans<double>(refShiftsX),
-      .ys = {ColMeans<double>(accuracyPC), ColMeans<double>(accuracyPCS), ColMeans<double>(accuracyIPC), ColMeans<double>(accuracyIPCO)},
-      .ylabels = {"pc", "pcs", "ipc", "ipco"},
+      .ys = {ColMeans<double>(accuracyPC), ColMeans<double>(accuracyPCS), ColMeans<double>(accuracyIPC), ColMeans<double>(accuracyIPCO), ColMeans<double>(accuracyIPCP)},
+      .ylabels = {"pc", "pcs", "ipc", "ipco", "ipcp"},
       .xlabel = "reference shift x [px]",
       .ylabel = "error [px]"});
 
@@ -91,6 +119,7 @@ void IPCMeasure::MeasureAccuracy(const IPC& ipc, const IPC& ipcopt, const std::s
   Plot::Plot({.name = "PCS accuracy", .z = accuracyPCS, .xmin = xmin, .xmax = xmax, .ymin = ymin, .ymax = ymax, .xlabel = xlabel, .ylabel = ylabel});
   Plot::Plot({.name = "IPC accuracy", .z = accuracyIPC, .xmin = xmin, .xmax = xmax, .ymin = ymin, .ymax = ymax, .xlabel = xlabel, .ylabel = ylabel});
   Plot::Plot({.name = "IPCO accuracy", .z = accuracyIPCO, .xmin = xmin, .xmax = xmax, .ymin = ymin, .ymax = ymax, .xlabel = xlabel, .ylabel = ylabel});
+  Plot::Plot({.name = "IPCP accuracy", .z = accuracyIPCP, .xmin = xmin, .xmax = xmax, .ymin = ymin, .ymax = ymax, .xlabel = xlabel, .ylabel = ylabel});
 
   Plot::Plot({.name = "PC accuracy", .z = accuracyPC, .xmin = xmin, .xmax = xmax, .ymin = ymin, .ymax = ymax, .xlabel = xlabel, .ylabel = ylabel});
   Plot::Plot({.name = "PCS accuracy", .z = accuracyPCS, .xmin = xmin, .xmax = xmax, .ymin = ymin, .ymax = ymax, .xlabel = xlabel, .ylabel = ylabel});
@@ -6,6 +6,8 @@ class IPC;
 class IPCMeasure
 {
   static constexpr double mQuanT = 0.95;
+  static constexpr int mPyramidLevels = 2;                // pyramid IPC coarse level downsampling 2^levels
+  static constexpr double mPyramidRefinementRatio = 0.5; // pyramid IPC full resolution window size relative to the IPC size
 
 public:
   static void MeasureAccuracy(const IPC& ipc, const IPC& ipcopt, const std::string& path);
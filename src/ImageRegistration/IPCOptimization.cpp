@@ -1,5 +1,6 @@
 #include "IPCOptimization.hpp"
 #include "IPC.hpp"
+#include "IPCStatic.hpp"
 #include "Optimization/Evolution.hpp"
 #include "ImageProcessing/Noise.hpp"
 #include "PhaseCorrelation.hpp"
@@ -18,10 +19,12 @@ try
     if (std::floor(ipc_.GetL2Usize() * ipc_.GetL1ratio()) < 3)
       return std::numeric_limits<double>::max();
 
+    // configurations with a precompiled static specialization are evaluated by it
+    const auto engine = CreateIPCEngine(ipc_);
     double avgerror = 0;
     for (const auto& imagePair : dataset.imagePairs)
     {
-      avgerror += Magnitude(ipc_.Calculate(imagePair.image1, imagePair.image2) - imagePair.shift);
+      avgerror += Magnitude(engine->Calculate(imagePair.image1, imagePair.image2) - imagePair.shift);
     }
     return avgerror / dataset.imagePairs.size();
   };
@@ -147,4 +150,5 @@ void IPCOptimization::ApplyOptimalParameters(IPC& ipc, const std::vector<double>
   LOG_INFO("Final IPC L2Usize: {} -> {}", ipcBefore.GetL2Usize(), ipc.GetL2Usize());
   LOG_INFO("Final IPC L1ratio: {:.2f} -> {:.2f}", ipcBefore.GetL1ratio(), ipc.GetL1ratio());
   LOG_INFO("Final IPC CPeps: {:.2e} -> {:.2e}", ipcBefore.GetCrossPowerEpsilon(), ipc.GetCrossPowerEpsilon());
+  LOG_INFO("Final IPC configuration {} a precompiled static specialization", CreateIPCEngine(ipc)->IsSpecialized() ? "has" : "does not have");
 }
@@ -0,0 +1,84 @@
+#include "IPCPyramid.hpp"
+#include "Utils/ParallelFor.hpp"
+
+IPCPyramid::IPCPyramid(const IPC& ipc, int levels, int refinementSize) : mSize(ipc.GetCols(), ipc.GetRows())
+{
+  if (levels < 1) [[unlikely]]
+    throw std::invalid_argument(fmt::format("Invalid pyramid level count ({} < 1)", levels));
+
+  // pyramid level sizes follow cv::pyrDown, each level samples every other pixel of the previous level
+  cv::Size coarseSize = mSize;
+  for (int level = 0; level < levels; ++level)
+    coarseSize = cv::Size((coarseSize.width + 1) / 2, (coarseSize.height + 1) / 2);
+
+  const cv::Size refinementWindow(std::min(refinementSize, mSize.width), std::min(refinementSize, mSize.height));
+  if (std::min(coarseSize.width, coarseSize.height) < ipc.GetL2size()) [[unlikely]]
+    throw std::invalid_argument(fmt::format("Pyramid coarse level size {} is too small for L2size {}", coarseSize, ipc.GetL2size()));
+
+  if (std::min(refinementWindow.width, refinementWindow.height) < ipc.GetL2size()) [[unlikely]]
+    throw std::invalid_argument(fmt::format("Pyramid refinement size {} is too small for L2size {}", refinementWindow, ipc.GetL2size()));
+
+  mIPCs.reserve(levels + 1);
+  for (int level = 0; level <= levels; ++level)
+  {
+    auto& levelIPC = mIPCs.emplace_back(ipc);
+    levelIPC.SetMaxShift(0); // the maximum shift of the full size IPC does not apply to the (downsampled) level windows
+    levelIPC.SetSize(level == 0 ? refinementWindow : coarseSize);
+  }
+}
+
+cv::Point2d IPCPyramid::Calculate(const cv::Mat& image1, const cv::Mat& image2, IPCWorkspace& workspace) const
+{
+  PROFILE_FUNCTION;
+  if (image1.size() != mSize or image2.size() != mSize) [[unlikely]]
+    throw std::invalid_argument(fmt::format("Invalid image size ({} / {} != {})", image1.size(), image2.size(), mSize));
+
+  const int levels = GetLevels();
+  std::vector<cv::Mat> pyramid1, pyramid2;
+  BuildPyramid(image1, pyramid1, levels);
+  BuildPyramid(image2, pyramid2, levels);
+
+  // coarse estimate over the full field of view, then residual shifts at each finer level, shifts double with every level
+  cv::Point2d shift = mIPCs[levels].Calculate(pyramid1[levels], pyramid2[levels], workspace);
+  for (int level = levels - 1; level >= 0; --level)
+    shift = CalculateResidual(mIPCs[level], pyramid1[level], pyramid2[level], 2 * shift, workspace);
+
+  return shift;
+}
+
+std::vector<cv::Point2d> IPCPyramid::CalculateBatch(std::span<const cv::Mat> images1, std::span<const cv::Mat> images2) const
+{
+  PROFILE_FUNCTION;
+  return ParallelForPairs(images1, images2, [this](const cv::Mat& image1, const cv::Mat& image2) { return Calculate(image1, image2); });
+}
+
+void IPCPyramid::BuildPyramid(const cv::Mat& image, std::vector<cv::Mat>& pyramid, int levels)
+{
+  PROFILE_FUNCTION;
+  // level 0 references the input image without a copy, cv::pyrDown supports 8U / 16U / 16S / 32F / 64F images only
+  pyramid.resize(levels + 1);
+  if (image.depth() == CV_8S or image.depth() == CV_32S) [[unlikely]]
+    image.convertTo(pyramid[0], CV_32F);
+  else
+    pyramid[0] = image;
+
+  for (int level = 1; level <= levels; ++level)
+    cv::pyrDown(pyramid[level - 1], pyramid[level]);
+}
+
+cv::Point2d IPCPyramid::CalculateResidual(const IPC& ipc, const cv::Mat& image1, const cv::Mat& image2, const cv::Point2d& prediction, IPCWorkspace& workspace)
+{
+  // window of image2 is offset by the predicted integer shift, both windows are kept inside the images and centered as well as possible
+  const auto align = [](double predicted, int window, int size)
+  {
+    const int offset = std::clamp(static_cast<int>(std::round(predicted)), window - size, size - window);
+    const int begin = std::clamp((size - window - offset) / 2, std::max(0, -offset), std::min(size - window, size - window - offset));
+    return std::pair{begin, offset};
+  };
+
+  const auto [x, dx] = align(prediction.x, ipc.GetCols(), image1.cols);
+  const auto [y, dy] = align(prediction.y, ipc.GetRows(), image1.rows);
+  const cv::Mat window1 = image1(cv::Rect(x, y, ipc.GetCols(), ipc.GetRows()));
+  const cv::Mat window2 = image2(cv::Rect(x + dx, y + dy, ipc.GetCols(), ipc.GetRows()));
+  return cv::Point2d(dx, dy) + ipc.Calculate(window1, window2, workspace);
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include "IPC.hpp"
+
+// coarse-to-fine pyramid IPC for large windows and large shifts, the shift is first estimated over the full field of view from the input images
+// downsampled 2^levels times, each finer pyramid level then registers windows aligned by the integer shift predicted by the previous level (so only
+// a small residual shift remains) and the full resolution level finishes with the normal subpixel refinement in a window of the refinement size
+class IPCPyramid
+{
+public:
+  // the IPC defines the input image size and all registration parameters, levels = number of 2x downsamplings of the coarse level,
+  // refinementSize = full resolution window size (limited to the IPC size), intermediate levels use windows of the coarse level size
+  IPCPyramid(const IPC& ipc, int levels, int refinementSize);
+
+  // calculate the subpixel image shift between image1 and image2, uses the calling thread's workspace
+  cv::Point2d Calculate(const cv::Mat& image1, const cv::Mat& image2) const { return Calculate(image1, image2, IPC::GetThreadWorkspace()); }
+
+  // calculate the subpixel image shift between image1 and image2
+  cv::Point2d Calculate(const cv::Mat& image1, const cv::Mat& image2, IPCWorkspace& workspace) const;
+
+  // calculate the subpixel image shifts between all image pairs (images1[i], images2[i]) in parallel
+  std::vector<cv::Point2d> CalculateBatch(std::span<const cv::Mat> images1, std::span<const cv::Mat> images2) const;
+
+  int GetLevels() const { return static_cast<int>(mIPCs.size()) - 1; }
+  cv::Size GetSize() const { return mSize; }
+
+  // IPC of the given pyramid level, level 0 = full resolution refinement, GetLevels() = coarse full field of view
+  const IPC& GetIPC(int level) const { return mIPCs[level]; }
+
+  // Gaussian pyramid of the image (cv::pyrDown), level 0 references the image without a copy, images of depths not supported by cv::pyrDown are
+  // converted to float
+  static void BuildPyramid(const cv::Mat& image, std::vector<cv::Mat>& pyramid, int levels);
+
+private:
+  cv::Size mSize;         // input image size
+  std::vector<IPC> mIPCs; // IPC of each pyramid level
+
+  static cv::Point2d CalculateResidual(const IPC& ipc, const cv::Mat& image1, const cv::Mat& image2, const cv::Point2d& prediction, IPCWorkspace& workspace);
+};
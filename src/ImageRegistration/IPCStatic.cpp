@@ -0,0 +1,73 @@
+#include "IPCStatic.hpp"
+#include "Utils/ParallelFor.hpp"
+
+namespace
+{
+class IPCDynamic : public IPCEngine
+{
+public:
+  explicit IPCDynamic(const IPC& ipc) : mIPC(ipc) {}
+
+  using IPCEngine::Calculate;
+  cv::Point2d Calculate(const cv::Mat& image1, const cv::Mat& image2, IPCWorkspace& workspace) const override { return mIPC.Calculate(image1, image2, workspace); }
+
+  using IPCEngine::CalculateResult;
+  IPC::Result CalculateResult(const cv::Mat& image1, const cv::Mat& image2, IPCWorkspace& workspace) const override { return mIPC.CalculateResult(image1, image2, workspace); }
+
+  cv::Point2d CalculateAccumulated(std::span<const cv::Mat> images1, std::span<const cv::Mat> images2, IPCWorkspace& workspace) const override
+  {
+    return mIPC.CalculateAccumulated(images1, images2, workspace);
+  }
+
+  bool IsSpecialized() const override { return false; }
+  const IPC& GetIPC() const override { return mIPC; }
+
+private:
+  IPC mIPC;
+};
+
+using Key = std::tuple<IPC::WindowType, IPC::BandpassType, IPC::InterpolationType, IPC::L1WindowType, int, int>; // WinT, BPT, IntT, L1WinT, L2size, L2Usize
+using Factory = std::unique_ptr<IPCEngine> (*)(const IPC&);
+
+template <IPC::WindowType WinT, IPC::BandpassType BPT, IPC::InterpolationType IntT, IPC::L1WindowType L1WinT, int L2size, int L2Usize>
+std::pair<const Key, Factory> Specialization()
+{
+  return {Key{WinT, BPT, IntT, L1WinT, L2size, L2Usize},
+      [](const IPC& ipc) -> std::unique_ptr<IPCEngine> { return std::make_unique<IPCStatic<WinT, BPT, IntT, L1WinT, L2size, L2Usize>>(ipc); }};
+}
+
+using WinT = IPC::WindowType;
+using BPT = IPC::BandpassType;
+using IntT = IPC::InterpolationType;
+using L1WinT = IPC::L1WindowType;
+
+// precompiled specializations, the IPC defaults and the configurations commonly selected by the IPC parameter optimization
+const std::map<Key, Factory> kSpecializations = {
+    Specialization<WinT::Hann, BPT::Gaussian, IntT::Linear, L1WinT::Circular, 7, 223>(),
+    Specialization<WinT::Hann, BPT::Gaussian, IntT::Cubic, L1WinT::Circular, 7, 223>(),
+    Specialization<WinT::Hann, BPT::Gaussian, IntT::DFTUpsample, L1WinT::Circular, 7, 223>(),
+    Specialization<WinT::Hann, BPT::None, IntT::Linear, L1WinT::None, 7, 223>(),
+};
+}
+
+std::unique_ptr<IPCEngine> CreateIPCEngine(const IPC& ipc)
+{
+  const Key key{ipc.GetWindowType(), ipc.GetBandpassType(), ipc.GetInterpolationType(), ipc.GetL1WindowType(), ipc.GetL2size(), ipc.GetL2Usize()};
+  if (const auto it = kSpecializations.find(key); it != kSpecializations.end() and ipc.GetL2size() <= std::min(ipc.GetRows(), ipc.GetCols()))
+    return it->second(ipc);
+
+  return std::make_unique<IPCDynamic>(ipc);
+}
+
+std::vector<cv::Point2d> IPCEngine::CalculateBatch(std::span<const cv::Mat> images1, std::span<const cv::Mat> images2) const
+{
+  PROFILE_FUNCTION;
+  return ParallelForPairs(images1, images2, [this](const cv::Mat& image1, const cv::Mat& image2) { return Calculate(image1, image2); });
+}
+
+std::vector<cv::Point2d> IPCEngine::CalculateAccumulatedBatch(std::span<const std::vector<cv::Mat>> images1, std::span<const std::vector<cv::Mat>> images2) const
+{
+  PROFILE_FUNCTION;
+  return ParallelForPairs(images1, images2,
+      [this](const std::vector<cv::Mat>& group1, const std::vector<cv::Mat>& group2) { return CalculateAccumulated(group1, group2, IPC::GetThreadWorkspace()); });
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include "IPC.hpp"
+
+// IPC registration engine, either a compile-time specialized IPC configuration (IPCStatic) or the runtime configured IPC
+class IPCEngine
+{
+public:
+  virtual ~IPCEngine() = default;
+
+  // calculate the subpixel image shift between image1 and image2
+  virtual cv::Point2d Calculate(const cv::Mat& image1, const cv::Mat& image2, IPCWorkspace& workspace) const = 0;
+
+  // calculate the subpixel image shift between image1 and image2, uses the calling thread's workspace
+  cv::Point2d Calculate(const cv::Mat& image1, const cv::Mat& image2) const { return Calculate(image1, image2, IPC::GetThreadWorkspace()); }
+
+  // calculate the subpixel image shift between image1 and image2 together with its peak quality
+  virtual IPC::Result CalculateResult(const cv::Mat& image1, const cv::Mat& image2, IPCWorkspace& workspace) const = 0;
+
+  // calculate the subpixel image shift and its peak quality, uses the calling thread's workspace
+  IPC::Result CalculateResult(const cv::Mat& image1, const cv::Mat& image2) const { return CalculateResult(image1, image2, IPC::GetThreadWorkspace()); }
+
+  // calculate a single subpixel image shift common to all image pairs (images1[i], images2[i])
+  virtual cv::Point2d CalculateAccumulated(std::span<const cv::Mat> images1, std::span<const cv::Mat> images2, IPCWorkspace& workspace) const = 0;
+
+  // calculate the subpixel image shifts of all image pairs (images1[i], images2[i]) in parallel
+  std::vector<cv::Point2d> CalculateBatch(std::span<const cv::Mat> images1, std::span<const cv::Mat> images2) const;
+
+  // calculate the accumulated subpixel image shifts of all image pair groups (images1[i], images2[i]) in parallel
+  std::vector<cv::Point2d> CalculateAccumulatedBatch(std::span<const std::vector<cv::Mat>> images1, std::span<const std::vector<cv::Mat>> images2) const;
+
+  // whether the engine runs a precompiled static specialization
+  virtual bool IsSpecialized() const = 0;
+
+  // the underlying IPC (its types and L2 sizes match the static configuration of specialized engines)
+  virtual const IPC& GetIPC() const = 0;
+};
+
+// IPC with the window, bandpass, interpolation and L1 window types and the L2 / L2U sizes fixed at compile time, the remaining runtime parameters
+// (size, bandpass cutoffs, L1 ratio, precision, ...) are taken from the given IPC, the hot path drops the branches on the fixed types and keeps the
+// fixed-size L2 on the stack, results are identical to the runtime configured IPC
+template <IPC::WindowType WinT, IPC::BandpassType BPT, IPC::InterpolationType IntT, IPC::L1WindowType L1WinT, int L2size, int L2Usize>
+class IPCStatic : public IPCEngine
+{
+public:
+  using Config = IPC::StaticConfig<WinT, BPT, IntT, L1WinT, L2size, L2Usize>;
+
+  explicit IPCStatic(const IPC& ipc) : mIPC(ipc)
+  {
+    if (L2size > ipc.GetRows() or L2size > ipc.GetCols()) [[unlikely]]
+      throw std::invalid_argument(fmt::format("IPC size {}x{} is too small for the static L2size {}", ipc.GetCols(), ipc.GetRows(), L2size));
+
+    mIPC.SetWindowType(WinT);
+    mIPC.SetBandpassType(BPT);
+    mIPC.SetInterpolationType(IntT);
+    mIPC.SetL1WindowType(L1WinT);
+    mIPC.SetL2size(L2size);
+    mIPC.SetL2Usize(L2Usize);
+  }
+
+  using IPCEngine::Calculate;
+  cv::Point2d Calculate(const cv::Mat& image1, const cv::Mat& image2, IPCWorkspace& workspace) const override
+  {
+    return mIPC.Calculate<IPC::Mode::Normal, Config>(image1, image2, workspace);
+  }
+
+  using IPCEngine::CalculateResult;
+  IPC::Result CalculateResult(const cv::Mat& image1, const cv::Mat& image2, IPCWorkspace& workspace) const override
+  {
+    return mIPC.CalculateResult<IPC::Mode::Normal, Config>(image1, image2, workspace);
+  }
+
+  cv::Point2d CalculateAccumulated(std::span<const cv::Mat> images1, std::span<const cv::Mat> images2, IPCWorkspace& workspace) const override
+  {
+    return mIPC.CalculateAccumulated<IPC::Mode::Normal, Config>(images1, images2, workspace);
+  }
+
+  bool IsSpecialized() const override { return true; }
+  const IPC& GetIPC() const override { return mIPC; }
+
+private:
+  IPC mIPC;
+};
+
+// create the registration engine of a runtime IPC configuration, a precompiled IPCStatic specialization is used when one matches the configuration
+// (types, L2 sizes and an IPC size which fits the L2), the runtime configured IPC otherwise
+std::unique_ptr<IPCEngine> CreateIPCEngine(const IPC& ipc);
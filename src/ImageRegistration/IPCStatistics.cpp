@@ -0,0 +1,85 @@
+#include "IPCStatistics.hpp"
+
+void IPCStatistics::AddAdaptiveFlow(uint64_t registrations, uint64_t pixels)
+{
+  sAdaptiveRegistrations.fetch_add(registrations, std::memory_order_relaxed);
+  sAdaptivePixels.fetch_add(pixels, std::memory_order_relaxed);
+  if (sScope)
+  {
+    sScope->mStats.adaptiveRegistrations += registrations;
+    sScope->mStats.adaptivePixels += pixels;
+  }
+}
+
+IPCStatistics::Snapshot IPCStatistics::Get()
+{
+  Snapshot snapshot;
+  snapshot.calls = sCalls.load(std::memory_order_relaxed);
+  snapshot.iterations = sIterations.load(std::memory_order_relaxed);
+  snapshot.L1ratioReductions = sL1ratioReductions.load(std::memory_order_relaxed);
+  snapshot.L2sizeReductions = sL2sizeReductions.load(std::memory_order_relaxed);
+  snapshot.nonConverged = sNonConverged.load(std::memory_order_relaxed);
+  snapshot.pixelLevel = sPixelLevel.load(std::memory_order_relaxed);
+  snapshot.rejected = sRejected.load(std::memory_order_relaxed);
+  snapshot.adaptiveRegistrations = sAdaptiveRegistrations.load(std::memory_order_relaxed);
+  snapshot.adaptivePixels = sAdaptivePixels.load(std::memory_order_relaxed);
+  for (size_t stage = 0; stage < snapshot.stageTimes.size(); ++stage)
+    snapshot.stageTimes[stage] = sStageTimes[stage].load(std::memory_order_relaxed);
+  return snapshot;
+}
+
+void IPCStatistics::Reset()
+{
+  sCalls.store(0, std::memory_order_relaxed);
+  sIterations.store(0, std::memory_order_relaxed);
+  sL1ratioReductions.store(0, std::memory_order_relaxed);
+  sL2sizeReductions.store(0, std::memory_order_relaxed);
+  sNonConverged.store(0, std::memory_order_relaxed);
+  sPixelLevel.store(0, std::memory_order_relaxed);
+  sRejected.store(0, std::memory_order_relaxed);
+  sAdaptiveRegistrations.store(0, std::memory_order_relaxed);
+  sAdaptivePixels.store(0, std::memory_order_relaxed);
+  for (auto& stageTime : sStageTimes)
+    stageTime.store(0, std::memory_order_relaxed);
+}
+
+std::string IPCStatistics::ToJson(int indent)
+{
+  const auto snapshot = Get();
+  json::json j;
+  j["calls"] = snapshot.calls;
+  j["iterations"] = snapshot.iterations;
+  j["iterationsPerCall"] = snapshot.calls ? static_cast<double>(snapshot.iterations) / snapshot.calls : 0.;
+  j["L1ratioReductions"] = snapshot.L1ratioReductions;
+  j["L2sizeReductions"] = snapshot.L2sizeReductions;
+  j["nonConverged"] = snapshot.nonConverged;
+  j["pixelLevel"] = snapshot.pixelLevel;
+  j["rejected"] = snapshot.rejected;
+  j["adaptiveRegistrations"] = snapshot.adaptiveRegistrations;
+  j["adaptivePixels"] = snapshot.adaptivePixels;
+  j["adaptiveRegistrationRatio"] = snapshot.adaptivePixels ? static_cast<double>(snapshot.adaptiveRegistrations) / snapshot.adaptivePixels : 0.;
+  for (size_t stage = 0; stage < snapshot.stageTimes.size(); ++stage)
+    j["stageTimesMs"][Stage2String(static_cast<Stage>(stage))] = snapshot.stageTimes[stage] * 1e-6;
+  return j.dump(indent);
+}
+
+std::string IPCStatistics::Stage2String(Stage stage)
+{
+  switch (stage)
+  {
+  case Stage::Prepare:
+    return "Prepare";
+  case Stage::FFT:
+    return "FFT";
+  case Stage::CrossPower:
+    return "CrossPower";
+  case Stage::L3:
+    return "L3";
+  case Stage::L2U:
+    return "L2U";
+  case Stage::Refinement:
+    return "Refinement";
+  default:
+    return "Unknown";
+  }
+}
@@ -0,0 +1,156 @@
+#pragma once
+#include <array>
+#include <atomic>
+
+// process-wide IPC runtime statistics, each registration accumulates its counters locally and publishes them once with relaxed atomic additions,
+// so the counters are cheap enough to stay always enabled (also outside of the debug mode), the per-stage timings cost two clock reads per stage and
+// are opt-in
+class IPCStatistics
+{
+public:
+  // IPC pipeline stage
+  enum class Stage : uint8_t
+  {
+    Prepare,    // input conversion & windowing
+    FFT,        // forward DFTs
+    CrossPower, // cross-power spectrum
+    L3,         // inverse DFT & peak search
+    L2U,        // L2 extraction & upsampling
+    Refinement, // iterative refinement
+    StageCount  // last
+  };
+
+  // statistics accumulated over all registrations since the last reset
+  struct Snapshot
+  {
+    uint64_t calls = 0;                                                          // number of registrations
+    uint64_t iterations = 0;                                                     // number of iterative refinement iterations
+    uint64_t L1ratioReductions = 0;                                              // number of L1ratio reductions due to non-convergence
+    uint64_t L2sizeReductions = 0;                                               // number of L2size reductions
+    uint64_t nonConverged = 0;                                                   // number of fallbacks to the non-iterative subpixel shift
+    uint64_t pixelLevel = 0;                                                     // number of pixel level only estimates
+    uint64_t rejected = 0;                                                       // number of results rejected by the peak quality gate
+    uint64_t adaptiveRegistrations = 0;                                          // number of IPC calls of the adaptive flows (out of bounds nodes are not registered)
+    uint64_t adaptivePixels = 0;                                                 // number of flow pixels of the adaptive flows (registered or interpolated)
+    std::array<uint64_t, static_cast<size_t>(Stage::StageCount)> stageTimes{}; // accumulated stage wall times [ns] (if timings are enabled)
+
+    Snapshot& operator+=(const Snapshot& other)
+    {
+      calls += other.calls;
+      iterations += other.iterations;
+      L1ratioReductions += other.L1ratioReductions;
+      L2sizeReductions += other.L2sizeReductions;
+      nonConverged += other.nonConverged;
+      pixelLevel += other.pixelLevel;
+      rejected += other.rejected;
+      adaptiveRegistrations += other.adaptiveRegistrations;
+      adaptivePixels += other.adaptivePixels;
+      for (size_t stage = 0; stage < stageTimes.size(); ++stage)
+        stageTimes[stage] += other.stageTimes[stage];
+      return *this;
+    }
+  };
+
+  class Call;
+
+  // collects the statistics of the registrations published by the calling thread during its lifetime in addition to the process-wide statistics,
+  // isolated from registrations running concurrently on other threads (scopes nest, the innermost scope collects)
+  class Scope
+  {
+  public:
+    Scope() : mParent(sScope) { sScope = this; }
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+    ~Scope() { sScope = mParent; }
+
+    const Snapshot& Get() const { return mStats; }
+
+  private:
+    friend class Call;
+    friend class IPCStatistics;
+    Snapshot mStats;
+    Scope* mParent;
+  };
+
+  // counters of a single registration, published on destruction
+  class Call
+  {
+  public:
+    Call() : mTimed(sTimingsEnabled.load(std::memory_order_relaxed))
+    {
+      if (mTimed)
+        mLast = Now();
+    }
+    Call(const Call&) = delete;
+    Call& operator=(const Call&) = delete;
+    ~Call() { Publish(); }
+
+    // attribute the time since the previous lap to the given stage
+    void Lap(Stage stage)
+    {
+      if (not mTimed)
+        return;
+
+      const auto now = Now();
+      mStats.stageTimes[static_cast<size_t>(stage)] += std::chrono::duration_cast<std::chrono::nanoseconds>(now - mLast).count();
+      mLast = now;
+    }
+
+    void AddIteration() { ++mStats.iterations; }
+    void AddL1ratioReduction() { ++mStats.L1ratioReductions; }
+    void AddL2sizeReduction() { ++mStats.L2sizeReductions; }
+    void AddNonConverged() { ++mStats.nonConverged; }
+    void AddPixelLevel() { ++mStats.pixelLevel; }
+    void AddRejected() { ++mStats.rejected; }
+
+  private:
+    Snapshot mStats{.calls = 1};
+    bool mTimed; // timings enabled when the registration started
+    std::chrono::steady_clock::time_point mLast;
+
+    static std::chrono::steady_clock::time_point Now() { return std::chrono::steady_clock::now(); }
+
+    void Publish()
+    {
+      Lap(Stage::Refinement); // the refinement is the last stage of every registration
+      sCalls.fetch_add(mStats.calls, std::memory_order_relaxed);
+      sIterations.fetch_add(mStats.iterations, std::memory_order_relaxed);
+      sL1ratioReductions.fetch_add(mStats.L1ratioReductions, std::memory_order_relaxed);
+      sL2sizeReductions.fetch_add(mStats.L2sizeReductions, std::memory_order_relaxed);
+      sNonConverged.fetch_add(mStats.nonConverged, std::memory_order_relaxed);
+      sPixelLevel.fetch_add(mStats.pixelLevel, std::memory_order_relaxed);
+      sRejected.fetch_add(mStats.rejected, std::memory_order_relaxed);
+      for (size_t stage = 0; stage < mStats.stageTimes.size(); ++stage)
+        if (mStats.stageTimes[stage])
+          sStageTimes[stage].fetch_add(mStats.stageTimes[stage], std::memory_order_relaxed);
+      if (sScope)
+        sScope->mStats += mStats;
+    }
+  };
+
+  // publish the registered & total flow pixels of an adaptive flow
+  static void AddAdaptiveFlow(uint64_t registrations, uint64_t pixels);
+
+  static Snapshot Get();
+  static void Reset();
+  static std::string ToJson(int indent = 2);
+  static std::string Stage2String(Stage stage);
+
+  // stage timings cost two clock reads per stage, they are disabled by default and only the counters are collected
+  static void SetTimingsEnabled(bool enabled) { sTimingsEnabled.store(enabled, std::memory_order_relaxed); }
+  static bool GetTimingsEnabled() { return sTimingsEnabled.load(std::memory_order_relaxed); }
+
+private:
+  inline static std::atomic<bool> sTimingsEnabled = false;
+  inline static thread_local Scope* sScope = nullptr;
+  inline static std::atomic<uint64_t> sCalls = 0;
+  inline static std::atomic<uint64_t> sIterations = 0;
+  inline static std::atomic<uint64_t> sL1ratioReductions = 0;
+  inline static std::atomic<uint64_t> sL2sizeReductions = 0;
+  inline static std::atomic<uint64_t> sNonConverged = 0;
+  inline static std::atomic<uint64_t> sPixelLevel = 0;
+  inline static std::atomic<uint64_t> sRejected = 0;
+  inline static std::atomic<uint64_t> sAdaptiveRegistrations = 0;
+  inline static std::atomic<uint64_t> sAdaptivePixels = 0;
+  inline static std::array<std::atomic<uint64_t>, static_cast<size_t>(Stage::StageCount)> sStageTimes{};
+};
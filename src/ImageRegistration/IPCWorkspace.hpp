@@ -0,0 +1,21 @@
+#pragma once
+
+// reusable buffers of the IPC intermediate results, buffers are only reallocated when the IPC size, precision or spectrum layout changes
+struct IPCWorkspace
+{
+  cv::Mat image1;       // converted & windowed input image 1
+  cv::Mat image2;       // converted & windowed input image 2
+  cv::Mat dft1;         // DFT of image 1
+  cv::Mat dft2;         // DFT of image 2, the cross-power spectrum is computed in place
+  cv::Mat crosspower;   // cross-power spectrum accumulated over the channels of multichannel images
+  cv::Mat halfSpectrum; // non-redundant complex columns of the CCS-packed cross-power spectrum
+  cv::Mat ramped;       // phase ramped half spectrum of the DFT grid evaluation
+  cv::Mat ramp;         // row & column phase ramps of the DFT grid evaluation
+  cv::Mat gridRows;     // DFT grid evaluated along the rows
+  cv::Mat grid;         // complex DFT grid
+  cv::Mat L3;           // phase correlation landscape (unshifted)
+  cv::Mat L2;           // maximum correlation neighborhood
+  cv::Mat L2U;          // upsampled L2
+  cv::Mat L2Usat;       // L2U summed-area tables used for the L1 centroids
+  cv::Mat L1;           // windowed L1
+};
@@ -0,0 +1,164 @@
+#include "CrossPower.hpp"
+
+#if defined(__GNUC__) and (defined(__x86_64__) or defined(__i386__))
+#  define CROSSPOWER_X86_DISPATCH
+#  include <immintrin.h>
+#endif
+
+SimdLevel GetSimdLevel()
+{
+  static const SimdLevel level = []()
+  {
+#ifdef CROSSPOWER_X86_DISPATCH
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+      return SimdLevel::AVX512;
+    if (__builtin_cpu_supports("avx2") and __builtin_cpu_supports("fma"))
+      return SimdLevel::AVX2;
+#endif
+    return SimdLevel::Scalar;
+  }();
+  return level;
+}
+
+std::string_view SimdLevel2String(SimdLevel level)
+{
+  switch (level)
+  {
+  case SimdLevel::Scalar:
+    return "Scalar";
+  case SimdLevel::AVX2:
+    return "AVX2";
+  case SimdLevel::AVX512:
+    return "AVX512";
+  default:
+    return "Unknown";
+  }
+}
+
+namespace
+{
+template <typename T>
+void CrossPowerSpectrumScalar(const T* dft1, const T* dft2, T* out, const T* band, int begin, int bins, T eps, bool normalize)
+{
+  for (int bin = begin; bin < bins; ++bin)
+    CrossPowerBin(dft1[2 * bin], dft1[2 * bin + 1], dft2[2 * bin], dft2[2 * bin + 1], out[2 * bin], out[2 * bin + 1], band ? band[bin] : T(1), eps, normalize);
+}
+
+#ifdef CROSSPOWER_X86_DISPATCH
+// complex vectors are interleaved [re, im, re, im, ...], conj(a) * b = [ar * br + ai * bi, ar * bi - ai * br] is computed by a single fmsubadd
+// of the duplicated real parts of a with b and the duplicated imaginary parts of a with the swapped b
+
+__attribute__((target("avx2,fma"))) void CrossPowerSpectrumAVX2(const double* dft1, const double* dft2, double* out, const double* band, int bins, double eps, bool normalize)
+{
+  const __m256d epsv = _mm256_set1_pd(eps);
+  int bin = 0;
+  for (; bin + 2 <= bins; bin += 2)
+  {
+    const __m256d a = _mm256_loadu_pd(dft1 + 2 * bin);
+    const __m256d b = _mm256_loadu_pd(dft2 + 2 * bin);
+    __m256d cp = _mm256_fmsubadd_pd(_mm256_movedup_pd(a), b, _mm256_mul_pd(_mm256_permute_pd(a, 0b1111), _mm256_permute_pd(b, 0b0101)));
+    if (normalize)
+    {
+      const __m256d sq = _mm256_mul_pd(cp, cp);
+      const __m256d mag = _mm256_sqrt_pd(_mm256_add_pd(sq, _mm256_permute_pd(sq, 0b0101)));
+      cp = _mm256_div_pd(cp, _mm256_add_pd(mag, epsv));
+    }
+    if (band)
+      cp = _mm256_mul_pd(cp, _mm256_permute4x64_pd(_mm256_castpd128_pd256(_mm_loadu_pd(band + bin)), 0b01010000));
+    _mm256_storeu_pd(out + 2 * bin, cp);
+  }
+  CrossPowerSpectrumScalar(dft1, dft2, out, band, bin, bins, eps, normalize);
+}
+
+__attribute__((target("avx2,fma"))) void CrossPowerSpectrumAVX2(const float* dft1, const float* dft2, float* out, const float* band, int bins, float eps, bool normalize)
+{
+  const __m256 epsv = _mm256_set1_ps(eps);
+  int bin = 0;
+  for (; bin + 4 <= bins; bin += 4)
+  {
+    const __m256 a = _mm256_loadu_ps(dft1 + 2 * bin);
+    const __m256 b = _mm256_loadu_ps(dft2 + 2 * bin);
+    __m256 cp = _mm256_fmsubadd_ps(_mm256_moveldup_ps(a), b, _mm256_mul_ps(_mm256_movehdup_ps(a), _mm256_permute_ps(b, 0b10110001)));
+    if (normalize)
+    {
+      const __m256 sq = _mm256_mul_ps(cp, cp);
+      const __m256 mag = _mm256_sqrt_ps(_mm256_add_ps(sq, _mm256_permute_ps(sq, 0b10110001)));
+      cp = _mm256_div_ps(cp, _mm256_add_ps(mag, epsv));
+    }
+    if (band)
+    {
+      const __m128 bandv = _mm_loadu_ps(band + bin);
+      cp = _mm256_mul_ps(cp, _mm256_set_m128(_mm_unpackhi_ps(bandv, bandv), _mm_unpacklo_ps(bandv, bandv)));
+    }
+    _mm256_storeu_ps(out + 2 * bin, cp);
+  }
+  CrossPowerSpectrumScalar(dft1, dft2, out, band, bin, bins, eps, normalize);
+}
+
+__attribute__((target("avx512f"))) void CrossPowerSpectrumAVX512(const double* dft1, const double* dft2, double* out, const double* band, int bins, double eps, bool normalize)
+{
+  const __m512d epsv = _mm512_set1_pd(eps);
+  const __m512i bandidx = _mm512_set_epi64(3, 3, 2, 2, 1, 1, 0, 0);
+  int bin = 0;
+  for (; bin + 4 <= bins; bin += 4)
+  {
+    const __m512d a = _mm512_loadu_pd(dft1 + 2 * bin);
+    const __m512d b = _mm512_loadu_pd(dft2 + 2 * bin);
+    __m512d cp = _mm512_fmsubadd_pd(_mm512_movedup_pd(a), b, _mm512_mul_pd(_mm512_permute_pd(a, 0xff), _mm512_permute_pd(b, 0x55)));
+    if (normalize)
+    {
+      const __m512d sq = _mm512_mul_pd(cp, cp);
+      const __m512d mag = _mm512_sqrt_pd(_mm512_add_pd(sq, _mm512_permute_pd(sq, 0x55)));
+      cp = _mm512_div_pd(cp, _mm512_add_pd(mag, epsv));
+    }
+    if (band)
+      cp = _mm512_mul_pd(cp, _mm512_permutexvar_pd(bandidx, _mm512_castpd256_pd512(_mm256_loadu_pd(band + bin))));
+    _mm512_storeu_pd(out + 2 * bin, cp);
+  }
+  CrossPowerSpectrumScalar(dft1, dft2, out, band, bin, bins, eps, normalize);
+}
+
+__attribute__((target("avx512f"))) void CrossPowerSpectrumAVX512(const float* dft1, const float* dft2, float* out, const float* band, int bins, float eps, bool normalize)
+{
+  const __m512 epsv = _mm512_set1_ps(eps);
+  const __m512i bandidx = _mm512_set_epi32(7, 7, 6, 6, 5, 5, 4, 4, 3, 3, 2, 2, 1, 1, 0, 0);
+  int bin = 0;
+  for (; bin + 8 <= bins; bin += 8)
+  {
+    const __m512 a = _mm512_loadu_ps(dft1 + 2 * bin);
+    const __m512 b = _mm512_loadu_ps(dft2 + 2 * bin);
+    __m512 cp = _mm512_fmsubadd_ps(_mm512_moveldup_ps(a), b, _mm512_mul_ps(_mm512_movehdup_ps(a), _mm512_permute_ps(b, 0b10110001)));
+    if (normalize)
+    {
+      const __m512 sq = _mm512_mul_ps(cp, cp);
+      const __m512 mag = _mm512_sqrt_ps(_mm512_add_ps(sq, _mm512_permute_ps(sq, 0b10110001)));
+      cp = _mm512_div_ps(cp, _mm512_add_ps(mag, epsv));
+    }
+    if (band)
+      cp = _mm512_mul_ps(cp, _mm512_permutexvar_ps(bandidx, _mm512_castps256_ps512(_mm256_loadu_ps(band + bin))));
+    _mm512_storeu_ps(out + 2 * bin, cp);
+  }
+  CrossPowerSpectrumScalar(dft1, dft2, out, band, bin, bins, eps, normalize);
+}
+#endif
+}
+
+template <typename T>
+void CrossPowerSpectrum(const T* dft1, const T* dft2, T* out, const T* band, int bins, T eps, bool normalize, SimdLevel level)
+{
+  switch (level)
+  {
+#ifdef CROSSPOWER_X86_DISPATCH
+  case SimdLevel::AVX512:
+    return CrossPowerSpectrumAVX512(dft1, dft2, out, band, bins, eps, normalize);
+  case SimdLevel::AVX2:
+    return CrossPowerSpectrumAVX2(dft1, dft2, out, band, bins, eps, normalize);
+#endif
+  default:
+    return CrossPowerSpectrumScalar(dft1, dft2, out, band, 0, bins, eps, normalize);
+  }
+}
+
+template void CrossPowerSpectrum<float>(const float*, const float*, float*, const float*, int, float, bool, SimdLevel);
+template void CrossPowerSpectrum<double>(const double*, const double*, double*, const double*, int, double, bool, SimdLevel);
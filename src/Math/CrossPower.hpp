@@ -0,0 +1,48 @@
+#pragma once
+
+// instruction set used by the vectorized spectral kernels
+enum class SimdLevel : uint8_t
+{
+  Scalar, // portable scalar loop
+  AVX2,   // AVX2 + FMA
+  AVX512, // AVX-512F
+};
+
+// highest instruction set supported by both the build and the cpu, detected once at runtime
+SimdLevel GetSimdLevel();
+
+std::string_view SimdLevel2String(SimdLevel level);
+
+// single cross-power spectrum bin conj(dft1) * dft2, optionally normalized to unit magnitude and multiplied by the band mask
+template <typename T>
+inline void CrossPowerBin(T dft1re, T dft1im, T dft2re, T dft2im, T& outre, T& outim, T band, T eps, bool normalize)
+{
+  const T re = dft1re * dft2re + dft1im * dft2im;
+  const T im = dft1re * dft2im - dft1im * dft2re;
+  if (normalize)
+  {
+    const T mag = std::sqrt(re * re + im * im);
+    outre = re / (mag + eps) * band;
+    outim = im / (mag + eps) * band;
+  }
+  else
+  {
+    outre = re * band;
+    outim = im * band;
+  }
+}
+
+// cross-power spectrum conj(dft1) * dft2 of a run of interleaved complex bins, optionally normalized to unit magnitude (with eps) and multiplied by a real
+// band mask (one value per bin, nullptr for none), out may alias dft1 or dft2
+template <typename T>
+void CrossPowerSpectrum(const T* dft1, const T* dft2, T* out, const T* band, int bins, T eps, bool normalize, SimdLevel level = GetSimdLevel());
+
+// row-wise cross-power spectrum of two complex (2-channel) spectra, out may alias dft1 or dft2
+template <typename T>
+inline void CrossPowerSpectrum(const cv::Mat& dft1, const cv::Mat& dft2, cv::Mat& out, const cv::Mat& band, T eps, bool normalize)
+{
+  PROFILE_FUNCTION;
+  const auto level = GetSimdLevel();
+  for (int row = 0; row < dft1.rows; ++row)
+    CrossPowerSpectrum<T>(dft1.ptr<T>(row), dft2.ptr<T>(row), out.ptr<T>(row), band.empty() ? nullptr : band.ptr<T>(row), dft1.cols, eps, normalize, level);
+}
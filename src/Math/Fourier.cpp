@@ -0,0 +1,98 @@
+#include "Fourier.hpp"
+#include <atomic>
+
+#ifdef ENABLE_FFTW
+const FFTEngine& GetFFTWEngine(); // FourierFFTW.cpp
+#endif
+
+namespace
+{
+class OpenCVFFTEngine : public FFTEngine
+{
+public:
+  void Forward(const cv::Mat& img, cv::Mat& out, bool packed) const override
+  {
+    PROFILE_FUNCTION;
+    cv::dft(img, out, packed ? 0 : cv::DFT_COMPLEX_OUTPUT);
+  }
+
+  void Inverse(const cv::Mat& spectrum, cv::Mat& out) const override
+  {
+    PROFILE_FUNCTION;
+    cv::dft(spectrum, out, cv::DFT_INVERSE | cv::DFT_SCALE | cv::DFT_REAL_OUTPUT);
+  }
+
+  void ForwardRows(const cv::Mat& img, cv::Mat& out) const override
+  {
+    PROFILE_FUNCTION;
+    cv::dft(img, out, cv::DFT_ROWS | cv::DFT_COMPLEX_OUTPUT);
+  }
+};
+
+std::atomic<FFTBackend> sFFTBackend = FFTBackend::OpenCV;
+}
+
+void SetFFTBackend(FFTBackend backend)
+{
+  if (not IsFFTBackendAvailable(backend)) [[unlikely]]
+    throw std::invalid_argument(fmt::format("FFT backend {} is not available in this build", FFTBackend2String(backend)));
+
+  sFFTBackend.store(backend, std::memory_order_relaxed);
+  LOG_DEBUG("FFT backend set to {}", FFTBackend2String(backend));
+}
+
+FFTBackend GetFFTBackend()
+{
+  return sFFTBackend.load(std::memory_order_relaxed);
+}
+
+bool IsFFTBackendAvailable(FFTBackend backend)
+{
+  switch (backend)
+  {
+  case FFTBackend::OpenCV:
+    return true;
+#ifdef ENABLE_FFTW
+  case FFTBackend::FFTW:
+    return true;
+#endif
+  default:
+    return false;
+  }
+}
+
+std::string FFTBackend2String(FFTBackend backend)
+{
+  switch (backend)
+  {
+  case FFTBackend::OpenCV:
+    return "OpenCV";
+  case FFTBackend::FFTW:
+    return "FFTW";
+  default:
+    return "Unknown";
+  }
+}
+
+const FFTEngine& GetFFTEngine()
+{
+  return GetFFTEngine(GetFFTBackend());
+}
+
+const FFTEngine& GetFFTEngine(FFTBackend backend)
+{
+  switch (backend)
+  {
+  case FFTBackend::OpenCV:
+  {
+    static const OpenCVFFTEngine engine;
+    return engine;
+  }
+#ifdef ENABLE_FFTW
+  case FFTBackend::FFTW:
+    return GetFFTWEngine();
+#endif
+  default:
+    throw std::invalid_argument(fmt::format("FFT backend {} is not available in this build", FFTBackend2String(backend)));
+  }
+}
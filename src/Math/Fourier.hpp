@@ -1,65 +1,100 @@
 #pragma once
 #include "Math/Functions.hpp"
 
-inline cv::Mat FFT(cv::Mat&& img)
+// FFT engine interface, the output buffers are provided by the caller and are only reallocated when their size or type does not match,
+// the output may be the input (in-place transform), allocation behaviour of the backends:
+// - OpenCV: cv::dft writes into the output buffer, it has no plans and its internal scratch buffers are allocated per call
+// - FFTW: plans are created once per size / precision / direction / layout, the half spectrum is computed into a per-thread scratch buffer which
+//   is reused between calls, full spectrum outputs of in-place forward transforms are reallocated (the output type differs from the input)
+class FFTEngine
+{
+public:
+  virtual ~FFTEngine() = default;
+
+  // forward DFT of a real single channel image, the output is either the full complex (2-channel) spectrum or the CCS-packed half spectrum
+  virtual void Forward(const cv::Mat& img, cv::Mat& out, bool packed) const = 0;
+
+  // scaled inverse DFT of a full complex or CCS-packed spectrum, the output is a real single channel image
+  virtual void Inverse(const cv::Mat& spectrum, cv::Mat& out) const = 0;
+
+  // forward 1D DFTs of the rows of a real single channel or complex (2-channel) image, the output is the full complex (2-channel) row spectra
+  virtual void ForwardRows(const cv::Mat& img, cv::Mat& out) const = 0;
+};
+
+enum class FFTBackend : uint8_t
+{
+  OpenCV,         // cv::dft
+  FFTW,           // FFTW3 with cached plans (requires ENABLE_FFTW)
+  FFTBackendCount // last
+};
+
+// process-wide FFT backend used by the FFT / IFFT functions below, throws if the backend is not available in this build
+void SetFFTBackend(FFTBackend backend);
+FFTBackend GetFFTBackend();
+bool IsFFTBackendAvailable(FFTBackend backend);
+std::string FFTBackend2String(FFTBackend backend);
+const FFTEngine& GetFFTEngine();
+const FFTEngine& GetFFTEngine(FFTBackend backend);
+
+// out of place transforms into caller-provided buffers, the buffers are only reallocated when their size or type does not match
+inline void FFT(const cv::Mat& img, cv::Mat& out)
 {
   PROFILE_FUNCTION;
-  cv::dft(img, img, cv::DFT_COMPLEX_OUTPUT);
-  return img;
+  GetFFTEngine().Forward(img, out, false);
 }
 
-inline cv::Mat IFFT(cv::Mat&& FFT)
+// real-to-complex FFT in the CCS-packed layout, the Hermitian-redundant half of the spectrum is not stored, IFFT accepts it directly
+inline void PackedFFT(const cv::Mat& img, cv::Mat& out)
 {
   PROFILE_FUNCTION;
-  cv::dft(FFT, FFT, cv::DFT_INVERSE | cv::DFT_SCALE | cv::DFT_REAL_OUTPUT);
-  return FFT;
+  GetFFTEngine().Forward(img, out, true);
 }
 
-inline cv::Mat GPUFFT(cv::Mat&& img)
+inline void IFFT(const cv::Mat& FFT, cv::Mat& out)
 {
   PROFILE_FUNCTION;
-  /*
-  cv::cuda::GpuMat imgGpu;
-  imgGpu.upload(img);
-  cv::cuda::dft(imgGpu, imgGpu, imgGpu.size());
-  imgGpu.download(img);
-  */
-  return img;
+  GetFFTEngine().Inverse(FFT, out);
 }
 
-inline cv::Mat GPUIFFT(cv::Mat&& FFT)
+// 1D FFTs of the image rows
+inline void RowFFT(const cv::Mat& img, cv::Mat& out)
 {
   PROFILE_FUNCTION;
-  /*
-  cv::cuda::GpuMat fftGpu;
-  fftGpu.upload(FFT);
-  cv::cuda::dft(fftGpu, fftGpu, fftGpu.size(), cv::DFT_INVERSE | cv::DFT_SCALE | cv::DFT_REAL_OUTPUT);
-  fftGpu.download(FFT);
-  */
-  return FFT;
+  GetFFTEngine().ForwardRows(img, out);
 }
 
-inline cv::Mat FFT(cv::Mat& img)
+// in-place transforms of temporaries
+inline cv::Mat FFT(cv::Mat&& img)
 {
-  return FFT(img.clone());
+  FFT(img, img);
+  return img;
 }
 
-inline cv::Mat IFFT(cv::Mat& FFT)
+inline cv::Mat PackedFFT(cv::Mat&& img)
 {
-  return IFFT(FFT.clone());
+  PackedFFT(img, img);
+  return img;
 }
 
-inline cv::Mat GPUFFT(cv::Mat& img)
+inline cv::Mat IFFT(cv::Mat&& FFT)
 {
-  return GPUFFT(img.clone());
+  IFFT(FFT, FFT);
+  return FFT;
 }
 
-inline cv::Mat GPUIFFT(cv::Mat& FFT)
+// transforms of lvalues keep the input intact
+inline cv::Mat FFT(cv::Mat& img)
 {
-  return GPUIFFT(FFT.clone());
+  return FFT(img.clone());
 }
 
-inline void FFTShift(cv::Mat& mat)
+inline cv::Mat IFFT(cv::Mat& FFT)
+{
+  return IFFT(FFT.clone());
+}
+
+// quadrant swap using a caller-provided temporary buffer
+inline void FFTShift(cv::Mat& mat, cv::Mat& tmp)
 {
   PROFILE_FUNCTION;
   int cx = mat.cols / 2;
@@ -69,7 +104,6 @@ inline void FFTShift(cv::Mat& mat)
   cv::Mat q2(mat, cv::Rect(0, cy, cx, cy));
   cv::Mat q3(mat, cv::Rect(cx, cy, cx, cy));
 
-  cv::Mat tmp;
   q0.copyTo(tmp);
   q3.copyTo(q0);
   tmp.copyTo(q3);
@@ -78,6 +112,12 @@ inline void FFTShift(cv::Mat& mat)
   tmp.copyTo(q2);
 }
 
+inline void FFTShift(cv::Mat& mat)
+{
+  cv::Mat tmp;
+  FFTShift(mat, tmp);
+}
+
 inline cv::Mat FFTShift(cv::Mat&& mat)
 {
   FFTShift(mat);
@@ -191,3 +231,13 @@ inline cv::Mat Hanning(cv::Size size)
   cv::createHanningWindow(mat, size, GetMatType<T>());
   return mat;
 }
+
+// 1D profile of the separable Hann window, Hanning(size)(r, c) = HanningProfile(rows)[r] * HanningProfile(cols)[c] (same as cv::createHanningWindow)
+inline std::vector<double> HanningProfile(int size)
+{
+  std::vector<double> profile(size);
+  const double coeff = 2. * std::numbers::pi / (size - 1);
+  for (int i = 0; i < size; ++i)
+    profile[i] = 0.5 * (1. - std::cos(coeff * i));
+  return profile;
+}
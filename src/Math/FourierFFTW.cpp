@@ -0,0 +1,327 @@
+#ifdef ENABLE_FFTW
+#  include "Fourier.hpp"
+#  include <fftw3.h>
+
+namespace
+{
+template <typename T>
+struct FFTWApi;
+
+template <>
+struct FFTWApi<double>
+{
+  using Complex = fftw_complex;
+  using Plan = fftw_plan;
+  static constexpr auto PlanR2C = fftw_plan_many_dft_r2c;
+  static constexpr auto PlanC2R = fftw_plan_many_dft_c2r;
+  static constexpr auto PlanC2C = fftw_plan_many_dft;
+  static constexpr auto ExecuteR2C = fftw_execute_dft_r2c;
+  static constexpr auto ExecuteC2R = fftw_execute_dft_c2r;
+  static constexpr auto ExecuteC2C = fftw_execute_dft;
+  static constexpr auto Destroy = fftw_destroy_plan;
+  static constexpr auto Malloc = fftw_malloc;
+  static constexpr auto Free = fftw_free;
+};
+
+template <>
+struct FFTWApi<float>
+{
+  using Complex = fftwf_complex;
+  using Plan = fftwf_plan;
+  static constexpr auto PlanR2C = fftwf_plan_many_dft_r2c;
+  static constexpr auto PlanC2R = fftwf_plan_many_dft_c2r;
+  static constexpr auto PlanC2C = fftwf_plan_many_dft;
+  static constexpr auto ExecuteR2C = fftwf_execute_dft_r2c;
+  static constexpr auto ExecuteC2R = fftwf_execute_dft_c2r;
+  static constexpr auto ExecuteC2C = fftwf_execute_dft;
+  static constexpr auto Destroy = fftwf_destroy_plan;
+  static constexpr auto Malloc = fftwf_malloc;
+  static constexpr auto Free = fftwf_free;
+};
+
+// FFTW3 backend, plans are created once per (size, precision, transform, output layout) and executed on the caller's arrays via the new-array
+// execute functions (thread-safe), FFTW computes the rows x (cols / 2 + 1) half spectrum which is then expanded to the full or CCS-packed layout
+class FFTWEngine : public FFTEngine
+{
+  enum class PlanType : uint8_t
+  {
+    Forward,            // 2D real-to-complex
+    Inverse,            // 2D complex-to-real
+    ForwardRowsReal,    // 1D real-to-complex of each row
+    ForwardRowsComplex, // 1D complex-to-complex of each row
+  };
+
+  // output row stride of the forward plans in complex elements (cols for writing directly into the full spectrum, cols / 2 + 1 for the half spectrum)
+  using PlanKey = std::tuple<int, int, int, PlanType, int>; // rows, cols, depth, type, stride
+
+  mutable std::mutex mMutex; // guards the plan cache and the (not thread-safe) FFTW planner
+  mutable std::map<PlanKey, void*> mPlans;
+
+public:
+  ~FFTWEngine() override
+  {
+    for (const auto& [key, plan] : mPlans)
+    {
+      if (std::get<2>(key) == CV_32F)
+        FFTWApi<float>::Destroy(static_cast<FFTWApi<float>::Plan>(plan));
+      else
+        FFTWApi<double>::Destroy(static_cast<FFTWApi<double>::Plan>(plan));
+    }
+  }
+
+  void Forward(const cv::Mat& img, cv::Mat& out, bool packed) const override
+  {
+    PROFILE_FUNCTION;
+    if (img.channels() != 1 or (img.depth() != CV_32F and img.depth() != CV_64F)) [[unlikely]]
+      throw std::invalid_argument("FFTW backend only supports real single channel float / double images");
+
+    if (img.depth() == CV_32F)
+      Forward<float>(img, out, packed);
+    else
+      Forward<double>(img, out, packed);
+  }
+
+  void Inverse(const cv::Mat& spectrum, cv::Mat& out) const override
+  {
+    PROFILE_FUNCTION;
+    if (spectrum.channels() > 2 or (spectrum.depth() != CV_32F and spectrum.depth() != CV_64F)) [[unlikely]]
+      throw std::invalid_argument("FFTW backend only supports float / double spectra");
+
+    if (spectrum.depth() == CV_32F)
+      Inverse<float>(spectrum, out);
+    else
+      Inverse<double>(spectrum, out);
+  }
+
+  void ForwardRows(const cv::Mat& img, cv::Mat& out) const override
+  {
+    PROFILE_FUNCTION;
+    if (img.channels() > 2 or (img.depth() != CV_32F and img.depth() != CV_64F)) [[unlikely]]
+      throw std::invalid_argument("FFTW backend only supports real / complex float / double images");
+
+    if (img.depth() == CV_32F)
+      ForwardRows<float>(img, out);
+    else
+      ForwardRows<double>(img, out);
+  }
+
+private:
+  template <typename T>
+  typename FFTWApi<T>::Plan GetPlan(int rows, int cols, PlanType type, int stride) const
+  {
+    using Api = FFTWApi<T>;
+    std::scoped_lock lock(mMutex);
+    auto& plan = mPlans[{rows, cols, GetMatType<T>(), type, stride}];
+    if (plan)
+      return static_cast<typename Api::Plan>(plan);
+
+    // plan with temporary arrays, FFTW_ESTIMATE does not touch their contents and FFTW_UNALIGNED allows executing on any cv::Mat data, the row
+    // transforms are planned as rows transforms of size cols with consecutive rows
+    const int n[] = {rows, cols};
+    const int realEmbed[] = {rows, cols};
+    const int complexEmbed[] = {rows, stride};
+    T* real = static_cast<T*>(Api::Malloc(sizeof(T) * rows * cols));
+    auto complex = static_cast<typename Api::Complex*>(Api::Malloc(sizeof(typename Api::Complex) * rows * std::max(cols, stride)));
+    auto complexIn = static_cast<typename Api::Complex*>(Api::Malloc(sizeof(typename Api::Complex) * rows * cols));
+    switch (type)
+    {
+    case PlanType::Forward:
+      plan = Api::PlanR2C(2, n, 1, real, realEmbed, 1, 0, complex, complexEmbed, 1, 0, FFTW_ESTIMATE | FFTW_UNALIGNED);
+      break;
+    case PlanType::Inverse:
+      plan = Api::PlanC2R(2, n, 1, complex, complexEmbed, 1, 0, real, realEmbed, 1, 0, FFTW_ESTIMATE | FFTW_UNALIGNED | FFTW_DESTROY_INPUT);
+      break;
+    case PlanType::ForwardRowsReal:
+      plan = Api::PlanR2C(1, n + 1, rows, real, nullptr, 1, cols, complex, nullptr, 1, stride, FFTW_ESTIMATE | FFTW_UNALIGNED);
+      break;
+    case PlanType::ForwardRowsComplex:
+      plan = Api::PlanC2C(1, n + 1, rows, complexIn, nullptr, 1, cols, complex, nullptr, 1, cols, FFTW_FORWARD, FFTW_ESTIMATE | FFTW_UNALIGNED);
+      break;
+    }
+    Api::Free(real);
+    Api::Free(complex);
+    Api::Free(complexIn);
+
+    if (not plan) [[unlikely]]
+      throw std::runtime_error(fmt::format("Failed to create FFTW plan for {}x{}", cols, rows));
+    return static_cast<typename Api::Plan>(plan);
+  }
+
+  // rows x (cols / 2 + 1) complex half spectrum scratch buffer of the calling thread
+  template <typename T>
+  static cv::Mat& GetHalfSpectrumBuffer(int rows, int cols)
+  {
+    thread_local cv::Mat buffer;
+    buffer.create(rows, cols / 2 + 1, GetMatType<T>(2));
+    return buffer;
+  }
+
+  template <typename T>
+  void Forward(const cv::Mat& img, cv::Mat& out, bool packed) const
+  {
+    using Api = FFTWApi<T>;
+    const int rows = img.rows;
+    const int cols = img.cols;
+    const cv::Mat input = img.isContinuous() ? img : img.clone();
+
+    if (not packed)
+    {
+      // write the half spectrum directly into the full spectrum rows and fill the rest using the Hermitian symmetry F(-r, -c) = conj(F(r, c)), the
+      // full spectrum of an in-place transform has a different type and is reallocated (the input stays alive through the input header), the plans
+      // write contiguous rows, so non-continuous outputs are filled from a temporary
+      const bool direct = out.data != img.data and out.isContinuous();
+      cv::Mat result = direct ? out : cv::Mat();
+      result.create(rows, cols, GetMatType<T>(2));
+      Api::ExecuteR2C(GetPlan<T>(rows, cols, PlanType::Forward, cols), const_cast<T*>(input.ptr<T>()), reinterpret_cast<typename Api::Complex*>(result.ptr<T>()));
+      for (int row = 0; row < rows; ++row)
+      {
+        auto resultp = result.ptr<cv::Vec<T, 2>>(row);
+        const auto mirrorp = result.ptr<cv::Vec<T, 2>>((rows - row) % rows);
+        for (int col = cols / 2 + 1; col < cols; ++col)
+          resultp[col] = {mirrorp[cols - col][0], -mirrorp[cols - col][1]};
+      }
+      if (not direct and out.data != img.data)
+        result.copyTo(out);
+      else
+        out = result;
+    }
+    else
+    {
+      // the input is fully consumed into the scratch buffer, so in-place packed transforms reuse the input buffer
+      cv::Mat& half = GetHalfSpectrumBuffer<T>(rows, cols);
+      Api::ExecuteR2C(GetPlan<T>(rows, cols, PlanType::Forward, half.cols), const_cast<T*>(input.ptr<T>()), reinterpret_cast<typename Api::Complex*>(half.ptr<T>()));
+      out.create(rows, cols, GetMatType<T>());
+      PackHalfSpectrum<T>(half, out);
+    }
+  }
+
+  template <typename T>
+  void Inverse(const cv::Mat& spectrum, cv::Mat& out) const
+  {
+    using Api = FFTWApi<T>;
+    const int rows = spectrum.rows;
+    const int cols = spectrum.cols;
+
+    // c2r destroys its input, so the half spectrum is always gathered into the scratch buffer
+    cv::Mat& half = GetHalfSpectrumBuffer<T>(rows, cols);
+    if (spectrum.channels() == 2)
+      spectrum.colRange(0, half.cols).copyTo(half);
+    else
+      UnpackHalfSpectrum<T>(spectrum, half);
+
+    // the spectrum is fully consumed into the scratch buffer, so in-place transforms of CCS-packed spectra reuse the spectrum buffer
+    out.create(rows, cols, GetMatType<T>());
+    cv::Mat result = out.isContinuous() ? out : cv::Mat(rows, cols, GetMatType<T>()); // the plans write contiguous rows
+    Api::ExecuteC2R(GetPlan<T>(rows, cols, PlanType::Inverse, half.cols), reinterpret_cast<typename Api::Complex*>(half.ptr<T>()), result.ptr<T>());
+    result.convertTo(out, -1, 1. / (static_cast<double>(rows) * cols)); // FFTW transforms are unnormalized
+  }
+
+  template <typename T>
+  void ForwardRows(const cv::Mat& img, cv::Mat& out) const
+  {
+    using Api = FFTWApi<T>;
+    const int rows = img.rows;
+    const int cols = img.cols;
+    const cv::Mat input = img.isContinuous() ? img : img.clone();
+
+    // the out-of-place plans write contiguous rows of a buffer distinct from the input, the row spectra of real rows are completed using the Hermitian
+    // symmetry F(-c) = conj(F(c))
+    const bool direct = out.data != img.data and out.isContinuous();
+    cv::Mat result = direct ? out : cv::Mat();
+    result.create(rows, cols, GetMatType<T>(2));
+    if (input.channels() == 2)
+    {
+      Api::ExecuteC2C(GetPlan<T>(rows, cols, PlanType::ForwardRowsComplex, cols), reinterpret_cast<typename Api::Complex*>(const_cast<T*>(input.ptr<T>())),
+          reinterpret_cast<typename Api::Complex*>(result.ptr<T>()));
+    }
+    else
+    {
+      Api::ExecuteR2C(GetPlan<T>(rows, cols, PlanType::ForwardRowsReal, cols), const_cast<T*>(input.ptr<T>()), reinterpret_cast<typename Api::Complex*>(result.ptr<T>()));
+      for (int row = 0; row < rows; ++row)
+      {
+        auto resultp = result.ptr<cv::Vec<T, 2>>(row);
+        for (int col = cols / 2 + 1; col < cols; ++col)
+          resultp[col] = {resultp[cols - col][0], -resultp[cols - col][1]};
+      }
+    }
+    if (not direct and out.data != img.data)
+      result.copyTo(out);
+    else
+      out = result;
+  }
+
+  // CCS-packed layout: columns (2k-1, 2k) hold the complex bins of column frequency k for all rows, while column 0 (and the last column for even cols)
+  // hold the purely real zero (and Nyquist) column frequency spectra packed along the rows in the same way
+  template <typename T>
+  static void PackHalfSpectrum(const cv::Mat& half, cv::Mat& packed)
+  {
+    const int rows = packed.rows;
+    const int cols = packed.cols;
+    for (int row = 0; row < rows; ++row)
+    {
+      const auto halfp = half.ptr<cv::Vec<T, 2>>(row);
+      auto packedp = packed.ptr<T>(row);
+      for (int col = 1; col + 1 < cols; col += 2)
+      {
+        packedp[col] = halfp[(col + 1) / 2][0];
+        packedp[col + 1] = halfp[(col + 1) / 2][1];
+      }
+    }
+
+    const auto packedColumn = [&](int col, int freqcol)
+    {
+      packed.at<T>(0, col) = half.at<cv::Vec<T, 2>>(0, freqcol)[0];
+      for (int row = 1; row + 1 < rows; row += 2)
+      {
+        packed.at<T>(row, col) = half.at<cv::Vec<T, 2>>((row + 1) / 2, freqcol)[0];
+        packed.at<T>(row + 1, col) = half.at<cv::Vec<T, 2>>((row + 1) / 2, freqcol)[1];
+      }
+      if (rows % 2 == 0)
+        packed.at<T>(rows - 1, col) = half.at<cv::Vec<T, 2>>(rows / 2, freqcol)[0];
+    };
+
+    packedColumn(0, 0);
+    if (cols % 2 == 0)
+      packedColumn(cols - 1, cols / 2);
+  }
+
+  template <typename T>
+  static void UnpackHalfSpectrum(const cv::Mat& packed, cv::Mat& half)
+  {
+    const int rows = packed.rows;
+    const int cols = packed.cols;
+    for (int row = 0; row < rows; ++row)
+    {
+      const auto packedp = packed.ptr<T>(row);
+      auto halfp = half.ptr<cv::Vec<T, 2>>(row);
+      for (int col = 1; col + 1 < cols; col += 2)
+        halfp[(col + 1) / 2] = {packedp[col], packedp[col + 1]};
+    }
+
+    const auto packedColumn = [&](int col, int freqcol)
+    {
+      half.at<cv::Vec<T, 2>>(0, freqcol) = {packed.at<T>(0, col), 0};
+      for (int row = 1; row + 1 < rows; row += 2)
+      {
+        const T re = packed.at<T>(row, col);
+        const T im = packed.at<T>(row + 1, col);
+        half.at<cv::Vec<T, 2>>((row + 1) / 2, freqcol) = {re, im};
+        half.at<cv::Vec<T, 2>>(rows - (row + 1) / 2, freqcol) = {re, -im};
+      }
+      if (rows % 2 == 0)
+        half.at<cv::Vec<T, 2>>(rows / 2, freqcol) = {packed.at<T>(rows - 1, col), 0};
+    };
+
+    packedColumn(0, 0);
+    if (cols % 2 == 0)
+      packedColumn(cols - 1, cols / 2);
+  }
+};
+}
+
+const FFTEngine& GetFFTWEngine()
+{
+  static const FFTWEngine engine;
+  return engine;
+}
+#endif
@@ -0,0 +1,53 @@
+#include <gtest/gtest.h>
+#include "Math/CrossPower.hpp"
+#include "Math/Functions.hpp"
+
+template <typename T>
+void TestSimdLevels(double tolerance)
+{
+  // odd column count exercises the scalar remainder of the vectorized loops
+  cv::Mat dft1(31, 67, GetMatType<T>(2));
+  cv::Mat dft2(31, 67, GetMatType<T>(2));
+  cv::Mat band(31, 67, GetMatType<T>());
+  cv::randu(dft1, cv::Scalar::all(-1), cv::Scalar::all(1));
+  cv::randu(dft2, cv::Scalar::all(-1), cv::Scalar::all(1));
+  cv::randu(band, cv::Scalar::all(0), cv::Scalar::all(1));
+
+  for (bool normalize : {false, true})
+  {
+    cv::Mat expected = dft2.clone();
+    for (int row = 0; row < dft1.rows; ++row)
+      CrossPowerSpectrum<T>(dft1.ptr<T>(row), dft2.ptr<T>(row), expected.ptr<T>(row), band.ptr<T>(row), dft1.cols, 1e-3, normalize, SimdLevel::Scalar);
+
+    for (int level = 0; level <= static_cast<int>(GetSimdLevel()); ++level)
+    {
+      cv::Mat out = dft2.clone(); // in-place into dft2 memory
+      for (int row = 0; row < dft1.rows; ++row)
+        CrossPowerSpectrum<T>(dft1.ptr<T>(row), out.ptr<T>(row), out.ptr<T>(row), band.ptr<T>(row), dft1.cols, 1e-3, normalize, static_cast<SimdLevel>(level));
+      EXPECT_LT(cv::norm(out, expected, cv::NORM_INF), tolerance) << SimdLevel2String(static_cast<SimdLevel>(level)) << " normalize: " << normalize;
+    }
+  }
+}
+
+TEST(CrossPowerTest, SimdLevelsFloat)
+{
+  TestSimdLevels<float>(1e-5);
+}
+
+TEST(CrossPowerTest, SimdLevelsDouble)
+{
+  TestSimdLevels<double>(1e-12);
+}
+
+TEST(CrossPowerTest, UnitMagnitude)
+{
+  cv::Mat dft1(16, 16, CV_64FC2);
+  cv::Mat dft2(16, 16, CV_64FC2);
+  cv::randu(dft1, cv::Scalar::all(-1), cv::Scalar::all(1));
+  cv::randu(dft2, cv::Scalar::all(-1), cv::Scalar::all(1));
+  CrossPowerSpectrum<double>(dft1, dft2, dft2, cv::Mat(), 0, true);
+
+  for (int row = 0; row < dft2.rows; ++row)
+    for (int col = 0; col < dft2.cols; ++col)
+      EXPECT_NEAR(std::hypot(dft2.at<cv::Vec2d>(row, col)[0], dft2.at<cv::Vec2d>(row, col)[1]), 1, 1e-12);
+}
@@ -21,3 +21,83 @@ TEST(FourierTest, ForwardInverseConsistency)
     for (int c = 0; c < img.cols; ++c)
       ASSERT_NEAR(ifft.at<float>(r, c), img.at<float>(r, c), 1e-6);
 }
+
+TEST(FourierTest, Backends)
+{
+  for (int size : {64, 75})
+  {
+    cv::Mat img(size, size + 1, CV_64F);
+    cv::randu(img, cv::Scalar(0), cv::Scalar(1));
+    const auto& reference = GetFFTEngine(FFTBackend::OpenCV);
+    cv::Mat referenceFFT, referencePacked;
+    reference.Forward(img, referenceFFT, false);
+    reference.Forward(img, referencePacked, true);
+
+    for (int backend = 0; backend < static_cast<int>(FFTBackend::FFTBackendCount); ++backend)
+    {
+      if (not IsFFTBackendAvailable(static_cast<FFTBackend>(backend)))
+        continue;
+
+      const auto& engine = GetFFTEngine(static_cast<FFTBackend>(backend));
+      cv::Mat fft, packed, ifft, ipacked;
+      engine.Forward(img, fft, false);
+      engine.Forward(img, packed, true);
+      ASSERT_EQ(fft.type(), referenceFFT.type());
+      ASSERT_EQ(packed.type(), referencePacked.type());
+      EXPECT_LT(cv::norm(fft, referenceFFT, cv::NORM_INF), 1e-9);
+      EXPECT_LT(cv::norm(packed, referencePacked, cv::NORM_INF), 1e-9);
+
+      engine.Inverse(referenceFFT, ifft);
+      engine.Inverse(referencePacked, ipacked);
+      EXPECT_LT(cv::norm(ifft, img, cv::NORM_INF), 1e-9);
+      EXPECT_LT(cv::norm(ipacked, img, cv::NORM_INF), 1e-9);
+
+      // in-place packed transforms keep the same type and size, so they reuse the buffer
+      cv::Mat inplace = img.clone();
+      const auto data = inplace.data;
+      engine.Forward(inplace, inplace, true);
+      EXPECT_EQ(inplace.data, data);
+      EXPECT_LT(cv::norm(inplace, referencePacked, cv::NORM_INF), 1e-9);
+      engine.Inverse(inplace, inplace);
+      EXPECT_EQ(inplace.data, data);
+      EXPECT_LT(cv::norm(inplace, img, cv::NORM_INF), 1e-9);
+
+      // row transforms of real and complex rows
+      cv::Mat rows, referenceRows, complexRows, referenceComplexRows;
+      reference.ForwardRows(img, referenceRows);
+      engine.ForwardRows(img, rows);
+      ASSERT_EQ(rows.type(), referenceRows.type());
+      EXPECT_LT(cv::norm(rows, referenceRows, cv::NORM_INF), 1e-9);
+      reference.ForwardRows(referenceFFT, referenceComplexRows);
+      engine.ForwardRows(referenceFFT, complexRows);
+      EXPECT_LT(cv::norm(complexRows, referenceComplexRows, cv::NORM_INF), 1e-9 * img.total());
+    }
+  }
+}
+
+TEST(FourierTest, LvalueTransformsKeepInput)
+{
+  cv::Mat img(64, 64, CV_32F);
+  cv::randu(img, cv::Scalar(0), cv::Scalar(1));
+  const cv::Mat original = img.clone();
+
+  cv::Mat fft = FFT(img);
+  EXPECT_EQ(cv::norm(img, original, cv::NORM_INF), 0);
+  const cv::Mat fftOriginal = fft.clone();
+  cv::Mat ifft = IFFT(fft);
+  EXPECT_EQ(cv::norm(fft, fftOriginal, cv::NORM_INF), 0);
+  EXPECT_LT(cv::norm(ifft, img, cv::NORM_INF), 1e-5);
+}
+
+TEST(FourierTest, UnavailableBackend)
+{
+  for (int backend = 0; backend < static_cast<int>(FFTBackend::FFTBackendCount); ++backend)
+  {
+    if (IsFFTBackendAvailable(static_cast<FFTBackend>(backend)))
+      continue;
+
+    EXPECT_THROW(SetFFTBackend(static_cast<FFTBackend>(backend)), std::invalid_argument);
+  }
+
+  EXPECT_EQ(GetFFTBackend(), FFTBackend::OpenCV);
+}
@@ -1,5 +1,8 @@
 #include <gtest/gtest.h>
 #include "ImageRegistration/IPC.hpp"
+#include "ImageRegistration/IPCFlow.hpp"
+#include "ImageRegistration/IPCPyramid.hpp"
+#include "ImageRegistration/IPCStatic.hpp"
 #include "Math/Transform.hpp"
 
 class IPCTest : public ::testing::Test
@@ -21,6 +24,12 @@ protected:
 
   IPC GetIPC() const { return IPC(mImg1.size()); }
 
+  // IPC-sized crops of the image pair at the image center
+  std::pair<cv::Mat, cv::Mat> GetCrops(const IPC& ipc) const
+  {
+    return {RoiCrop(mImg1, 500, 500, ipc.GetCols(), ipc.GetRows()), RoiCrop(mImg2, 500, 500, ipc.GetCols(), ipc.GetRows())};
+  }
+
   cv::Point2d mShift = cv::Point2d(38.638, -67.425);
   // cppcheck-suppress unusedStructMember
   static constexpr double kTolerance = 1e-7;
@@ -127,6 +136,16 @@ TEST_F(IPCTest, InterpolationTypes)
   const auto shiftCubic = ipc.Calculate(mImg1, mImg2);
   EXPECT_NEAR(shiftCubic.x, mShift.x, 0.5);
   EXPECT_NEAR(shiftCubic.y, mShift.y, 0.5);
+
+  ipc.SetInterpolationType(InterpolationType::DFTUpsample);
+  const auto shiftDFT = ipc.Calculate(mImg1, mImg2);
+  EXPECT_NEAR(shiftDFT.x, mShift.x, 0.5);
+  EXPECT_NEAR(shiftDFT.y, mShift.y, 0.5);
+
+  ipc.SetHalfSpectrum(true);
+  const auto shiftDFTHalf = ipc.Calculate(mImg1, mImg2);
+  EXPECT_NEAR(shiftDFTHalf.x, shiftDFT.x, kTolerance);
+  EXPECT_NEAR(shiftDFTHalf.y, shiftDFT.y, kTolerance);
 }
 
 TEST_F(IPCTest, BandpassTypes)
@@ -164,3 +183,724 @@ TEST_F(IPCTest, WindowTypes)
   EXPECT_NEAR(shiftHann.x, mShift.x, 0.5);
   EXPECT_NEAR(shiftHann.y, mShift.y, 0.5);
 }
+
+TEST_F(IPCTest, Batch)
+{
+  IPC ipc(256, 256);
+  std::vector<cv::Mat> images1, images2;
+  for (int i = 0; i < 8; ++i)
+  {
+    images1.push_back(RoiCrop(mImg1, 500 + 10 * i, 500 - 5 * i, ipc.GetCols(), ipc.GetRows()));
+    images2.push_back(RoiCrop(mImg2, 500 + 10 * i, 500 - 5 * i, ipc.GetCols(), ipc.GetRows()));
+  }
+
+  const auto shifts = ipc.CalculateBatch(images1, images2);
+  ASSERT_EQ(shifts.size(), images1.size());
+  for (size_t i = 0; i < shifts.size(); ++i)
+    EXPECT_EQ(shifts[i], ipc.Calculate(images1[i], images2[i]));
+
+  EXPECT_THROW(ipc.CalculateBatch(images1, std::span(images2).subspan(1)), std::invalid_argument);
+}
+
+TEST_F(IPCTest, Reference)
+{
+  const auto ipc = GetIPC();
+  const auto reference = ipc.PrepareReference(mImg1);
+  EXPECT_EQ(ipc.Calculate(reference, mImg2), ipc.Calculate(mImg1, mImg2));
+  EXPECT_EQ(ipc.Calculate(reference, mImg1), ipc.Calculate(mImg1, mImg1));
+  EXPECT_THROW(ipc.Calculate(reference, cv::Mat::ones(mImg1.rows + 1, mImg1.cols + 1, CV_32F)), std::invalid_argument);
+  EXPECT_THROW(ipc.PrepareReference(cv::Mat::ones(mImg1.rows + 1, mImg1.cols + 1, CV_32F)), std::invalid_argument);
+}
+
+TEST_F(IPCTest, Precision)
+{
+  auto ipc = GetIPC();
+  const auto shift64 = ipc.Calculate(mImg1, mImg2);
+  const auto reference64 = ipc.PrepareReference(mImg1);
+
+  ipc.SetPrecision(IPC::Precision::Float32);
+  const auto shift32 = ipc.Calculate(mImg1, mImg2);
+  EXPECT_NEAR(shift32.x, shift64.x, 1e-3);
+  EXPECT_NEAR(shift32.y, shift64.y, 1e-3);
+  EXPECT_EQ(ipc.Calculate(ipc.PrepareReference(mImg1), mImg2), shift32);
+  EXPECT_THROW(ipc.Calculate(reference64, mImg2), std::invalid_argument);
+}
+
+TEST_F(IPCTest, HalfSpectrum)
+{
+  auto ipc = GetIPC();
+  const auto shiftFull = ipc.Calculate(mImg1, mImg2);
+  ipc.SetHalfSpectrum(true);
+  const auto shiftHalf = ipc.Calculate(mImg1, mImg2);
+  EXPECT_NEAR(shiftHalf.x, shiftFull.x, kTolerance);
+  EXPECT_NEAR(shiftHalf.y, shiftFull.y, kTolerance);
+  EXPECT_EQ(ipc.Calculate(ipc.PrepareReference(mImg1), mImg2), shiftHalf);
+
+  IPC ipcOdd(255, 257);
+  ipcOdd.SetBandpassType(BandpassType::None);
+  const auto [crop1, crop2] = GetCrops(ipcOdd);
+  const auto shiftOddFull = ipcOdd.Calculate(crop1, crop2);
+  ipcOdd.SetHalfSpectrum(true);
+  const auto shiftOddHalf = ipcOdd.Calculate(crop1, crop2);
+  EXPECT_NEAR(shiftOddHalf.x, shiftOddFull.x, kTolerance);
+  EXPECT_NEAR(shiftOddHalf.y, shiftOddFull.y, kTolerance);
+}
+
+TEST_F(IPCTest, Workspace)
+{
+  IPC ipc(256, 256);
+  IPCWorkspace workspace;
+  const auto view1 = RoiCropRef(mImg1, 500, 500, ipc.GetCols(), ipc.GetRows());
+  const auto view2 = RoiCropRef(mImg2, 500, 500, ipc.GetCols(), ipc.GetRows());
+  ASSERT_FALSE(view1.isContinuous());
+
+  // non-continuous views give the same result as continuous copies
+  const auto shift = ipc.Calculate(view1, view2, workspace);
+  EXPECT_EQ(shift, ipc.Calculate(view1.clone(), view2.clone()));
+
+  // steady state calls reuse all workspace buffers
+  const std::vector<const void*> buffers = {workspace.image1.data, workspace.image2.data, workspace.dft1.data, workspace.dft2.data, workspace.L3.data, workspace.L2U.data};
+  EXPECT_EQ(ipc.Calculate(view1, view2, workspace), shift);
+  const std::vector<const void*> buffersReused = {workspace.image1.data, workspace.image2.data, workspace.dft1.data, workspace.dft2.data, workspace.L3.data, workspace.L2U.data};
+  EXPECT_EQ(buffers, buffersReused);
+}
+
+TEST_F(IPCTest, OptimalDFTSize)
+{
+  IPC ipc(251, 257); // prime sizes
+  const auto [crop1, crop2] = GetCrops(ipc);
+  const auto shiftUnpadded = ipc.Calculate(crop1, crop2);
+
+  ipc.SetOptimalDFTSize(true);
+  ASSERT_EQ(ipc.GetDFTSize(), cv::Size(cv::getOptimalDFTSize(257), cv::getOptimalDFTSize(251)));
+  ASSERT_EQ(ipc.GetBandpass().size(), ipc.GetDFTSize());
+  const auto shiftPadded = ipc.Calculate(crop1, crop2);
+  EXPECT_NEAR(shiftPadded.x, mShift.x, 0.5);
+  EXPECT_NEAR(shiftPadded.y, mShift.y, 0.5);
+  EXPECT_NEAR(shiftPadded.x, shiftUnpadded.x, 0.1);
+  EXPECT_NEAR(shiftPadded.y, shiftUnpadded.y, 0.1);
+  EXPECT_EQ(ipc.Calculate(ipc.PrepareReference(crop1), crop2), shiftPadded);
+
+  ipc.SetHalfSpectrum(true);
+  const auto shiftPaddedHalf = ipc.Calculate(crop1, crop2);
+  EXPECT_NEAR(shiftPaddedHalf.x, shiftPadded.x, kTolerance);
+  EXPECT_NEAR(shiftPaddedHalf.y, shiftPadded.y, kTolerance);
+}
+
+TEST_F(IPCTest, MaskCache)
+{
+  IPC ipc1(256, 256);
+  IPC ipc2(256, 256);
+  EXPECT_EQ(ipc1.GetBandpass().data, ipc2.GetBandpass().data);
+  EXPECT_EQ(ipc1.GetWindow().data, ipc2.GetWindow().data);
+
+  ipc2.SetBandpassParameters(0.1, 0.9);
+  EXPECT_NE(ipc1.GetBandpass().data, ipc2.GetBandpass().data);
+  ipc1.SetBandpassParameters(0.1, 0.9);
+  EXPECT_EQ(ipc1.GetBandpass().data, ipc2.GetBandpass().data);
+
+  ipc2.SetPrecision(IPC::Precision::Float32);
+  EXPECT_NE(ipc1.GetWindow().data, ipc2.GetWindow().data);
+  EXPECT_EQ(ipc2.GetWindow().type(), CV_32F);
+
+  // separable gaussian bandpass matches the direct evaluation
+  const int rows = 255, cols = 256;
+  const double bpL = 0.1, bpH = 0.9;
+  IPC ipc(rows, cols, bpL, bpH);
+  cv::Mat expected(rows, cols, CV_64F);
+  const auto lowpass = [&](int r, int c, double sigma)
+  {
+    const int fr = r < (rows + 1) / 2 ? r : r - rows; // signed frequencies of the unshifted spectrum
+    const int fc = c < (cols + 1) / 2 ? c : c - cols;
+    return std::exp(-1.0 / (2. * std::pow(sigma, 2)) * (std::pow(fc, 2) / std::pow(cols / 2, 2) + std::pow(fr, 2) / std::pow(rows / 2, 2)));
+  };
+  for (int r = 0; r < rows; ++r)
+    for (int c = 0; c < cols; ++c)
+      expected.at<double>(r, c) = lowpass(r, c, bpH) * (1.0 - lowpass(r, c, bpL));
+  cv::normalize(expected, expected, 0.0, 1.0, cv::NORM_MINMAX);
+  EXPECT_LT(cv::norm(ipc.GetBandpass(), expected, cv::NORM_INF), 1e-12);
+}
+
+TEST_F(IPCTest, OddSizes)
+{
+  for (const auto& size : {cv::Size(255, 255), cv::Size(257, 254), cv::Size(254, 257)})
+  {
+    IPC ipc(size);
+    const auto [crop1, crop2] = GetCrops(ipc);
+    const auto shift = ipc.Calculate(crop1, crop2);
+    EXPECT_NEAR(shift.x, mShift.x, 0.5);
+    EXPECT_NEAR(shift.y, mShift.y, 0.5);
+
+    const auto zeroShift = ipc.Calculate(crop1, crop1);
+    EXPECT_NEAR(zeroShift.x, 0, kTolerance);
+    EXPECT_NEAR(zeroShift.y, 0, kTolerance);
+  }
+}
+
+TEST_F(IPCTest, Multichannel)
+{
+  IPC ipc(256, 256);
+  const auto [crop1, crop2] = GetCrops(ipc);
+  const auto shift = ipc.Calculate(crop1, crop2);
+
+  // identical channels give the single channel result
+  cv::Mat multi1, multi2;
+  cv::merge(std::vector<cv::Mat>{crop1, crop1, crop1}, multi1);
+  cv::merge(std::vector<cv::Mat>{crop2, crop2, crop2}, multi2);
+  const auto shiftMulti = ipc.Calculate(multi1, multi2);
+  EXPECT_NEAR(shiftMulti.x, shift.x, kTolerance);
+  EXPECT_NEAR(shiftMulti.y, shift.y, kTolerance);
+
+  // independent channels of different contrast
+  std::vector<cv::Mat> channels1, channels2;
+  for (int channel = 0; channel < 3; ++channel)
+  {
+    cv::Mat image(mImg1.size(), CV_32F);
+    cv::randu(image, cv::Scalar(0), cv::Scalar(1. + channel));
+    cv::Mat imageShifted = image.clone();
+    Shift(imageShifted, mShift);
+    channels1.push_back(RoiCrop(image, 500, 500, ipc.GetCols(), ipc.GetRows()));
+    channels2.push_back(RoiCrop(imageShifted, 500, 500, ipc.GetCols(), ipc.GetRows()));
+  }
+  cv::merge(channels1, multi1);
+  cv::merge(channels2, multi2);
+  const auto shiftChannels = ipc.Calculate(multi1, multi2);
+  EXPECT_NEAR(shiftChannels.x, mShift.x, 0.5);
+  EXPECT_NEAR(shiftChannels.y, mShift.y, 0.5);
+
+  ipc.SetHalfSpectrum(true);
+  const auto shiftChannelsHalf = ipc.Calculate(multi1, multi2);
+  EXPECT_NEAR(shiftChannelsHalf.x, shiftChannels.x, kTolerance);
+  EXPECT_NEAR(shiftChannelsHalf.y, shiftChannels.y, kTolerance);
+
+  EXPECT_THROW(ipc.Calculate(multi1, crop2), std::invalid_argument);
+}
+
+TEST_F(IPCTest, Statistics)
+{
+  IPC ipc(256, 256);
+  const auto [crop1, crop2] = GetCrops(ipc);
+
+  // the counters are always collected, the scope isolates the registrations of this thread from concurrently running ones
+  {
+    IPCStatistics::Scope scope;
+    ipc.Calculate(crop1, crop2);
+    EXPECT_EQ(scope.Get().calls, 1);
+    EXPECT_GE(scope.Get().iterations, 1);
+    if (not IPCStatistics::GetTimingsEnabled())
+    {
+      EXPECT_EQ(scope.Get().stageTimes[static_cast<size_t>(IPCStatistics::Stage::FFT)], 0);
+    }
+  }
+
+  // the stage timings are opt-in
+  const bool timings = IPCStatistics::GetTimingsEnabled();
+  IPCStatistics::SetTimingsEnabled(true);
+  {
+    IPCStatistics::Scope scope;
+    ipc.Calculate(crop1, crop2);
+    ipc.Calculate(crop1, crop2);
+    EXPECT_EQ(scope.Get().calls, 2);
+    EXPECT_GE(scope.Get().iterations, 2);
+    EXPECT_GT(scope.Get().stageTimes[static_cast<size_t>(IPCStatistics::Stage::FFT)], 0);
+  }
+  IPCStatistics::SetTimingsEnabled(timings);
+
+  // the process-wide statistics include all registrations
+  const auto before = IPCStatistics::Get();
+  ipc.Calculate(crop1, crop2);
+  EXPECT_GE(IPCStatistics::Get().calls - before.calls, 1);
+  EXPECT_NE(IPCStatistics::ToJson().find("iterationsPerCall"), std::string::npos);
+}
+
+TEST_F(IPCTest, L1WindowTypes)
+{
+  auto ipc = GetIPC();
+  for (const auto type : {IPC::L1WindowType::None, IPC::L1WindowType::Circular, IPC::L1WindowType::Gaussian})
+  {
+    ipc.SetL1WindowType(type);
+    const auto shift = ipc.Calculate(mImg1, mImg2);
+    EXPECT_NEAR(shift.x, mShift.x, 0.5);
+    EXPECT_NEAR(shift.y, mShift.y, 0.5);
+
+    const auto zeroShift = ipc.Calculate(mImg1, mImg1);
+    EXPECT_NEAR(zeroShift.x, 0, kTolerance);
+    EXPECT_NEAR(zeroShift.y, 0, kTolerance);
+  }
+}
+
+TEST_F(IPCTest, MaxShift)
+{
+  // the plausible-shift sub-grid holds the same correlation values as the full L3 for even (full IPC) and odd (cropped IPC) DFT sizes
+  IPC ipcOdd(251, 257);
+  const auto [crop1, crop2] = GetCrops(ipcOdd);
+  for (auto [ipc, image1, image2] : {std::tuple{GetIPC(), mImg1, mImg2}, std::tuple{ipcOdd, crop1, crop2}})
+  {
+    for (const bool halfSpectrum : {false, true})
+    {
+      ipc.SetHalfSpectrum(halfSpectrum);
+      ipc.SetMaxShift(0);
+      const auto shiftFull = ipc.Calculate(image1, image2);
+
+      ipc.SetMaxShift(8, cv::Point2i(35, -70));
+      const auto shift = ipc.Calculate(image1, image2);
+      EXPECT_NEAR(shift.x, shiftFull.x, kTolerance);
+      EXPECT_NEAR(shift.y, shiftFull.y, kTolerance);
+
+      // the peak is only searched within the maximum shift of the prediction (the refined shift stays within the L2 neighborhood of the peak)
+      ipc.SetMaxShift(8);
+      const auto zeroShift = ipc.Calculate(image1, image1);
+      EXPECT_NEAR(zeroShift.x, 0, kTolerance);
+      EXPECT_NEAR(zeroShift.y, 0, kTolerance);
+      const auto shiftOutside = ipc.Calculate(image1, image2);
+      EXPECT_LE(std::abs(shiftOutside.x), 8 + ipc.GetL2size() / 2);
+      EXPECT_LE(std::abs(shiftOutside.y), 8 + ipc.GetL2size() / 2);
+    }
+  }
+}
+
+TEST_F(IPCTest, InputDepths)
+{
+  IPC ipc(256, 256);
+  const auto crop1 = RoiCropRef(mImg1, 500, 500, ipc.GetCols(), ipc.GetRows());
+  const auto crop2 = RoiCropRef(mImg2, 500, 500, ipc.GetCols(), ipc.GetRows());
+
+  // integer images are preprocessed straight from the source pixels with the same result as converting them to float first
+  for (const auto& [depth, scale] : {std::pair{CV_8U, 255.}, std::pair{CV_16U, 65535.}})
+  {
+    cv::Mat image1, image2, image1F, image2F;
+    crop1.convertTo(image1, depth, scale);
+    crop2.convertTo(image2, depth, scale);
+    image1.convertTo(image1F, CV_32F);
+    image2.convertTo(image2F, CV_32F);
+    EXPECT_EQ(ipc.Calculate(image1, image2), ipc.Calculate(image1F, image2F));
+  }
+
+  // the mean removal makes the shift invariant to intensity offsets
+  ipc.SetRemoveMean(true);
+  const auto shift = ipc.Calculate(crop1, crop2);
+  EXPECT_NEAR(shift.x, mShift.x, 0.5);
+  EXPECT_NEAR(shift.y, mShift.y, 0.5);
+  cv::Mat crop2Offset;
+  crop2.convertTo(crop2Offset, CV_64F, 1, 100);
+  const auto shiftOffset = ipc.Calculate(crop1, crop2Offset);
+  EXPECT_NEAR(shiftOffset.x, shift.x, kTolerance);
+  EXPECT_NEAR(shiftOffset.y, shift.y, kTolerance);
+}
+
+TEST_F(IPCTest, StaticConfiguration)
+{
+  // the default configuration has a precompiled specialization with results identical to the runtime configured IPC
+  auto ipc = GetIPC();
+  for (const auto precision : {IPC::Precision::Float64, IPC::Precision::Float32})
+  {
+    ipc.SetPrecision(precision);
+    const auto engine = CreateIPCEngine(ipc);
+    EXPECT_TRUE(engine->IsSpecialized());
+    EXPECT_EQ(engine->Calculate(mImg1, mImg2), ipc.Calculate(mImg1, mImg2));
+    EXPECT_EQ(engine->CalculateResult(mImg1, mImg2).quality, ipc.CalculateResult(mImg1, mImg2).quality);
+    const std::vector<cv::Mat> images1{mImg1, mImg1}, images2{mImg2, mImg2};
+    EXPECT_EQ(engine->CalculateAccumulated(images1, images2, IPC::GetThreadWorkspace()), ipc.CalculateAccumulated(images1, images2));
+    EXPECT_EQ(engine->CalculateBatch(images1, images2), ipc.CalculateBatch(images1, images2));
+  }
+
+  // the static configuration overrides the types and L2 sizes of the given IPC
+  const IPCStatic<WindowType::Hann, BandpassType::None, InterpolationType::Cubic, IPC::L1WindowType::Gaussian, 5, 151> ipcStatic(ipc);
+  EXPECT_EQ(ipcStatic.GetIPC().GetBandpassType(), BandpassType::None);
+  EXPECT_EQ(ipcStatic.GetIPC().GetL2size(), 5);
+  EXPECT_EQ(ipcStatic.Calculate(mImg1, mImg2), ipcStatic.GetIPC().Calculate(mImg1, mImg2));
+
+  // configurations without a precompiled specialization fall back to the runtime configured IPC
+  ipc.SetL2Usize(224);
+  const auto engine = CreateIPCEngine(ipc);
+  EXPECT_FALSE(engine->IsSpecialized());
+  EXPECT_EQ(engine->Calculate(mImg1, mImg2), ipc.Calculate(mImg1, mImg2));
+
+  IPC ipcSmall(5, 5);
+  EXPECT_FALSE(CreateIPCEngine(ipcSmall)->IsSpecialized());
+  EXPECT_THROW((IPCStatic<WindowType::Hann, BandpassType::Gaussian, InterpolationType::Linear, IPC::L1WindowType::Circular, 7, 223>(ipcSmall)), std::invalid_argument);
+}
+
+TEST_F(IPCTest, PeakQuality)
+{
+  auto ipc = GetIPC();
+  const auto result = ipc.CalculateResult(mImg1, mImg2);
+  EXPECT_TRUE(result.valid);
+  EXPECT_GT(result.quality, 10);
+  EXPECT_EQ(result.shift, ipc.Calculate(mImg1, mImg2));
+
+  // unrelated images have no distinct correlation peak
+  cv::Mat noise1(mImg1.size(), CV_32F), noise2(mImg1.size(), CV_32F);
+  cv::randu(noise1, cv::Scalar(0), cv::Scalar(1));
+  cv::randu(noise2, cv::Scalar(0), cv::Scalar(1));
+  const auto noiseResult = ipc.CalculateResult(noise1, noise2);
+  EXPECT_TRUE(noiseResult.valid);
+  EXPECT_LT(noiseResult.quality, 10);
+
+  // low quality peaks are rejected with the pixel level shift
+  ipc.SetMinPeakQuality(10);
+  {
+    IPCStatistics::Scope scope;
+    const auto rejected = ipc.CalculateResult(noise1, noise2);
+    EXPECT_FALSE(rejected.valid);
+    EXPECT_EQ(rejected.quality, noiseResult.quality);
+    EXPECT_EQ(rejected.shift.x, std::round(rejected.shift.x));
+    EXPECT_EQ(rejected.shift.y, std::round(rejected.shift.y));
+    EXPECT_EQ(scope.Get().rejected, 1);
+    EXPECT_EQ(scope.Get().iterations, 0);
+  }
+
+  const auto accepted = ipc.CalculateResult(mImg1, mImg2);
+  EXPECT_TRUE(accepted.valid);
+  EXPECT_EQ(accepted.shift, result.shift);
+}
+
+TEST_F(IPCTest, Accumulated)
+{
+  IPC ipc(256, 256);
+  const auto [crop1, crop2] = GetCrops(ipc);
+  const auto shift = ipc.Calculate(crop1, crop2);
+
+  // a single pair gives the pairwise result, repeated pairs only scale the accumulated correlation surface
+  const auto shiftSingle = ipc.CalculateAccumulated(std::vector<cv::Mat>{crop1}, std::vector<cv::Mat>{crop2});
+  EXPECT_NEAR(shiftSingle.x, shift.x, kTolerance);
+  EXPECT_NEAR(shiftSingle.y, shift.y, kTolerance);
+  const auto shiftRepeated = ipc.CalculateAccumulated(std::vector<cv::Mat>{crop1, crop1, crop1}, std::vector<cv::Mat>{crop2, crop2, crop2});
+  EXPECT_NEAR(shiftRepeated.x, shift.x, kTolerance);
+  EXPECT_NEAR(shiftRepeated.y, shift.y, kTolerance);
+
+  // independent pairs with a common shift, one of them without any correlation
+  std::vector<cv::Mat> images1, images2;
+  for (int pair = 0; pair < 4; ++pair)
+  {
+    cv::Mat image(mImg1.size(), CV_32F);
+    cv::randu(image, cv::Scalar(0), cv::Scalar(1));
+    cv::Mat imageShifted = image.clone();
+    if (pair == 3)
+      cv::randu(imageShifted, cv::Scalar(0), cv::Scalar(1));
+    else
+      Shift(imageShifted, mShift);
+    images1.push_back(RoiCrop(image, 500, 500, ipc.GetCols(), ipc.GetRows()));
+    images2.push_back(RoiCrop(imageShifted, 500, 500, ipc.GetCols(), ipc.GetRows()));
+  }
+
+  IPCStatistics::Scope scope;
+  const auto shiftAccumulated = ipc.CalculateAccumulated(images1, images2);
+  EXPECT_NEAR(shiftAccumulated.x, mShift.x, 0.5);
+  EXPECT_NEAR(shiftAccumulated.y, mShift.y, 0.5);
+  EXPECT_EQ(scope.Get().calls, 1);
+
+  const std::vector<std::vector<cv::Mat>> groups1{images1, {crop1}}, groups2{images2, {crop2}};
+  const auto shifts = ipc.CalculateAccumulatedBatch(groups1, groups2);
+  ASSERT_EQ(shifts.size(), 2);
+  EXPECT_EQ(shifts[0], shiftAccumulated);
+  EXPECT_EQ(shifts[1], shiftSingle);
+
+  EXPECT_THROW(ipc.CalculateAccumulated(images1, std::vector<cv::Mat>{crop2}), std::invalid_argument);
+  EXPECT_THROW(ipc.CalculateAccumulated(std::vector<cv::Mat>{}, std::vector<cv::Mat>{}), std::invalid_argument);
+  EXPECT_THROW(ipc.CalculateAccumulated(std::vector<cv::Mat>{mImg1}, std::vector<cv::Mat>{mImg2}), std::invalid_argument);
+}
+
+TEST_F(IPCTest, Pyramid)
+{
+  const auto ipc = GetIPC();
+  const IPCPyramid pyramid(ipc, 2, 500);
+  ASSERT_EQ(pyramid.GetLevels(), 2);
+  EXPECT_EQ(pyramid.GetIPC(2).GetCols(), 250);
+  EXPECT_EQ(pyramid.GetIPC(0).GetCols(), 500);
+
+  const auto shift = pyramid.Calculate(mImg1, mImg2);
+  EXPECT_NEAR(shift.x, mShift.x, 0.5);
+  EXPECT_NEAR(shift.y, mShift.y, 0.5);
+
+  // integer input images are converted for the pyramid downsampling
+  cv::Mat img1i, img2i;
+  mImg1.convertTo(img1i, CV_32S, 1000);
+  mImg2.convertTo(img2i, CV_32S, 1000);
+  const auto shiftInteger = pyramid.Calculate(img1i, img2i);
+  EXPECT_NEAR(shiftInteger.x, mShift.x, 0.5);
+  EXPECT_NEAR(shiftInteger.y, mShift.y, 0.5);
+
+  const auto shifts = pyramid.CalculateBatch(std::vector<cv::Mat>{mImg1, mImg1}, std::vector<cv::Mat>{mImg2, mImg1});
+  ASSERT_EQ(shifts.size(), 2);
+  EXPECT_EQ(shifts[0], shift);
+  EXPECT_NEAR(shifts[1].x, 0, kTolerance);
+  EXPECT_NEAR(shifts[1].y, 0, kTolerance);
+
+  EXPECT_THROW(IPCPyramid(ipc, 0, 500), std::invalid_argument);
+  EXPECT_THROW(IPCPyramid(ipc, 8, 500), std::invalid_argument);
+  EXPECT_THROW(pyramid.Calculate(RoiCrop(mImg1, 500, 500, 256, 256), RoiCrop(mImg2, 500, 500, 256, 256)), std::invalid_argument);
+}
+
+TEST_F(IPCTest, Flow)
+{
+  cv::Mat shifted = mImg1.clone();
+  Shift(shifted, cv::Point2d(1.3, -0.7));
+  const auto image1 = RoiCrop(mImg1, 500, 500, 160, 120);
+  const auto image2 = RoiCrop(shifted, 500, 500, 160, 120);
+  const double resolution = 0.25;
+
+  // the flow matches independent registrations of the windows centered at every 1 / resolution pixels, exactly for the per-window spectra and up to
+  // the tolerance for the shared spectra
+  const auto test = [&](const IPC& ipc, double tolerance)
+  {
+    for (const auto spectra : {IPCFlow::Spectra::PerWindow, IPCFlow::Spectra::Shared})
+    {
+      const auto [flowX, flowY] = IPCFlow::CalculateFlow(ipc, image1, image2, resolution, spectra);
+      ASSERT_EQ(flowX.size(), cv::Size(40, 30));
+      ASSERT_EQ(flowY.size(), cv::Size(40, 30));
+      for (int r = 0; r < flowX.rows; ++r)
+        for (int c = 0; c < flowX.cols; ++c)
+        {
+          const cv::Point2i center(c / resolution, r / resolution);
+          const bool inside = center.x - ipc.GetCols() / 2 >= 0 and center.y - ipc.GetRows() / 2 >= 0 and center.x + ipc.GetCols() / 2 < image1.cols and
+                              center.y + ipc.GetRows() / 2 < image1.rows;
+          cv::Point2d shift(0, 0);
+          if (inside)
+            shift = ipc.Calculate(RoiCropRef(image1, center.x, center.y, ipc.GetCols(), ipc.GetRows()),
+                RoiCropRef(image2, center.x, center.y, ipc.GetCols(), ipc.GetRows()));
+          EXPECT_NEAR(flowX.at<IPC::Float>(r, c), shift.x, spectra == IPCFlow::Spectra::Shared ? tolerance : 0);
+          EXPECT_NEAR(flowY.at<IPC::Float>(r, c), shift.y, spectra == IPCFlow::Spectra::Shared ? tolerance : 0);
+        }
+    }
+  };
+
+  IPC ipc(32, 32);
+  test(ipc, 1e-6);
+  ipc.SetRemoveMean(true);
+  test(ipc, 1e-6);
+  ipc.SetWindowType(WindowType::None);
+  test(ipc, 1e-6);
+
+  IPC ipcOdd(29, 31);
+  ipcOdd.SetOptimalDFTSize(true);
+  ipcOdd.SetRemoveMean(true);
+  test(ipcOdd, 1e-6);
+  ipcOdd.SetPrecision(IPC::Precision::Float32);
+  test(ipcOdd, 1e-3);
+  ipcOdd.SetHalfSpectrum(true);
+  test(ipcOdd, 0);
+}
+
+TEST_F(IPCTest, FlowPyramid)
+{
+  const cv::Point2d shift(9.4, -6.8);
+  cv::Mat shifted = mImg1.clone();
+  Shift(shifted, shift);
+  const auto image1 = RoiCrop(mImg1, 500, 500, 256, 192);
+  const auto image2 = RoiCrop(shifted, 500, 500, 256, 192);
+  const double resolution = 0.125;
+  const IPC ipc(16, 16);
+
+  // small windows register motions beyond their size when pre-shifted by the coarser levels
+  const auto [flowX, flowY] = IPCFlow::CalculateFlowPyramid(ipc, image1, image2, resolution, 2);
+  ASSERT_EQ(flowX.size(), cv::Size(32, 24));
+  const int margin = ipc.GetCols() / 2 + 10;
+  for (int r = 0; r < flowX.rows; ++r)
+    for (int c = 0; c < flowX.cols; ++c)
+    {
+      const cv::Point2i center(c / resolution, r / resolution);
+      if (center.x < margin or center.y < margin or center.x + margin >= image1.cols or center.y + margin >= image1.rows)
+        continue;
+
+      EXPECT_NEAR(flowX.at<IPC::Float>(r, c), shift.x, 0.5);
+      EXPECT_NEAR(flowY.at<IPC::Float>(r, c), shift.y, 0.5);
+    }
+
+  const auto [flowX0, flowY0] = IPCFlow::CalculateFlowPyramid(ipc, image1, image2, resolution, 0);
+  const auto [flowXRef, flowYRef] = IPCFlow::CalculateFlow(ipc, image1, image2, resolution);
+  EXPECT_EQ(cv::norm(flowX0, flowXRef, cv::NORM_INF), 0);
+  EXPECT_EQ(cv::norm(flowY0, flowYRef, cv::NORM_INF), 0);
+
+  EXPECT_THROW(IPCFlow::CalculateFlowPyramid(ipc, image1, image2, resolution, 5), std::invalid_argument);
+}
+
+TEST_F(IPCTest, FlowTiled)
+{
+  cv::Mat shifted = mImg1.clone();
+  Shift(shifted, cv::Point2d(1.3, -0.7));
+  const auto image1 = RoiCrop(mImg1, 500, 500, 160, 120);
+  const auto image2 = RoiCrop(shifted, 500, 500, 160, 120);
+  const double resolution = 0.25;
+
+  // tiles that do not divide the flow size match the single pass flow (up to the rounding of the tile-local window means of the shared spectra)
+  const auto test = [&](const IPC& ipc, double tolerance)
+  {
+    for (const auto spectra : {IPCFlow::Spectra::PerWindow, IPCFlow::Spectra::Shared})
+    {
+      const auto [flowXRef, flowYRef] = IPCFlow::CalculateFlow(ipc, image1, image2, resolution, spectra);
+      for (const int tileSize : {7, 16, 64})
+      {
+        cv::Mat flowX, flowY;
+        IPCFlow::CalculateFlowTiled(ipc, image1, image2, resolution, flowX, flowY, tileSize, spectra);
+        ASSERT_EQ(flowX.size(), flowXRef.size());
+        EXPECT_LE(cv::norm(flowX, flowXRef, cv::NORM_INF), spectra == IPCFlow::Spectra::Shared ? tolerance : 0);
+        EXPECT_LE(cv::norm(flowY, flowYRef, cv::NORM_INF), spectra == IPCFlow::Spectra::Shared ? tolerance : 0);
+      }
+    }
+  };
+
+  IPC ipc(32, 32);
+  test(ipc, 1e-9);
+  ipc.SetRemoveMean(true);
+  test(ipc, 1e-9);
+  ipc.SetHalfSpectrum(true);
+  test(ipc, 0);
+
+  // the source only has to provide the requested image regions and every flow pixel reaches the sink exactly once
+  std::mutex mutex;
+  cv::Mat coverage = cv::Mat::zeros(30, 40, CV_32S);
+  IPCFlow::CalculateFlowTiled(
+      ipc, image1.size(), resolution,
+      [&](const cv::Rect& rect, cv::Mat& tile1, cv::Mat& tile2)
+      {
+        tile1 = image1(rect).clone();
+        tile2 = image2(rect).clone();
+      },
+      [&](const cv::Rect& flowRect, const cv::Mat& flowX, const cv::Mat&)
+      {
+        ASSERT_EQ(flowX.size(), flowRect.size());
+        std::scoped_lock lock(mutex);
+        coverage(flowRect) += 1;
+      },
+      9);
+  double minCoverage, maxCoverage;
+  cv::minMaxLoc(coverage, &minCoverage, &maxCoverage);
+  EXPECT_EQ(minCoverage, 1);
+  EXPECT_EQ(maxCoverage, 1);
+
+  // preallocated flow is written in place, mismatched preallocated flow is rejected
+  std::vector<IPC::Float> buffer(40 * 30, -1);
+  cv::Mat flowX(30, 40, GetMatType<IPC::Float>(), buffer.data()), flowY;
+  IPCFlow::CalculateFlowTiled(ipc, image1, image2, resolution, flowX, flowY);
+  EXPECT_EQ(flowX.ptr<IPC::Float>(), buffer.data());
+  EXPECT_EQ(std::count(buffer.begin(), buffer.end(), -1), 0);
+  cv::Mat flowSmall(10, 10, GetMatType<IPC::Float>());
+  EXPECT_THROW(IPCFlow::CalculateFlowTiled(ipc, image1, image2, resolution, flowSmall, flowY), std::invalid_argument);
+}
+
+TEST_F(IPCTest, FlowSequence)
+{
+  std::vector<cv::Mat> frames;
+  for (int i = 0; i < IPCFlow::kSequenceChunk + 2; ++i) // the ordered frame source is registered in two chunks
+  {
+    cv::Mat shifted = mImg1.clone();
+    Shift(shifted, cv::Point2d(0.3 * i, -0.2 * i));
+    frames.push_back(RoiCrop(shifted, 500, 500, 160, 120));
+  }
+  const double resolution = 0.25;
+
+  // the flows of the consecutive frames match the tiled flows of the separate pairs, the per-window spectra of the sequence are the IPC reference spectra
+  const auto test = [&](const IPC& ipc, IPCFlow::Spectra spectra, double tolerance)
+  {
+    const auto flows = IPCFlow::CalculateFlowSequence(ipc, frames, resolution, spectra);
+    ASSERT_EQ(flows.size(), frames.size() - 1);
+    for (size_t pair = 0; pair < flows.size(); ++pair)
+    {
+      cv::Mat flowXRef, flowYRef;
+      IPCFlow::CalculateFlowTiled(ipc, frames[pair], frames[pair + 1], resolution, flowXRef, flowYRef, IPCFlow::kTileSize, spectra);
+      const auto& [flowX, flowY] = flows[pair];
+      ASSERT_EQ(flowX.size(), flowXRef.size());
+      EXPECT_LE(cv::norm(flowX, flowXRef, cv::NORM_INF), tolerance);
+      EXPECT_LE(cv::norm(flowY, flowYRef, cv::NORM_INF), tolerance);
+    }
+
+    // the ordered frame source emits the same flows in pair order
+    size_t index = 0;
+    int pairs = 0;
+    IPCFlow::CalculateFlowSequence(
+        ipc,
+        [&](cv::Mat& frame)
+        {
+          if (index == frames.size())
+            return false;
+          frame = frames[index++];
+          return true;
+        },
+        resolution,
+        [&](int pair, const cv::Mat& flowX, const cv::Mat& flowY)
+        {
+          ASSERT_EQ(pair, pairs++);
+          EXPECT_EQ(cv::norm(flowX, std::get<0>(flows[pair]), cv::NORM_INF), 0);
+          EXPECT_EQ(cv::norm(flowY, std::get<1>(flows[pair]), cv::NORM_INF), 0);
+        },
+        spectra);
+    EXPECT_EQ(pairs, static_cast<int>(flows.size()));
+  };
+
+  IPC ipc(32, 32);
+  test(ipc, IPCFlow::Spectra::Shared, 0);
+  test(ipc, IPCFlow::Spectra::PerWindow, 1e-9);
+  ipc.SetRemoveMean(true);
+  test(ipc, IPCFlow::Spectra::Shared, 0);
+  test(ipc, IPCFlow::Spectra::PerWindow, 1e-9);
+  ipc.SetPrecision(IPC::Precision::Float32);
+  test(ipc, IPCFlow::Spectra::Shared, 0);
+  test(ipc, IPCFlow::Spectra::PerWindow, 1e-9);
+  ipc.SetHalfSpectrum(true);
+  test(ipc, IPCFlow::Spectra::PerWindow, 1e-9);
+
+  EXPECT_TRUE(IPCFlow::CalculateFlowSequence(ipc, std::span(frames).first(1), resolution).empty());
+  const std::vector<cv::Mat> mismatched{frames[0], frames[1](cv::Rect(0, 0, 100, 100))};
+  EXPECT_THROW(IPCFlow::CalculateFlowSequence(ipc, mismatched, resolution), std::invalid_argument);
+}
+
+TEST_F(IPCTest, FlowAdaptive)
+{
+  const cv::Point2d shiftLeft(1.3, -0.7), shiftRight(-1.2, 0.9);
+  cv::Mat shiftedLeft = mImg1.clone(), shiftedRight = mImg1.clone();
+  Shift(shiftedLeft, shiftLeft);
+  Shift(shiftedRight, shiftRight);
+  const auto image1 = RoiCrop(mImg1, 500, 500, 160, 120);
+  const auto image2 = RoiCrop(shiftedLeft, 500, 500, 160, 120);
+  const double resolution = 0.25;
+  const IPC ipc(32, 32);
+
+  // registering every node is the per-window dense flow, which registers the same windows with the same IPC engine
+  IPCStatistics::Scope scope;
+  const auto [flowXRef, flowYRef] = IPCFlow::CalculateFlow(ipc, image1, image2, resolution, IPCFlow::Spectra::PerWindow);
+  const auto [flowX1, flowY1] = IPCFlow::CalculateFlowAdaptive(ipc, image1, image2, resolution, 1);
+  ASSERT_EQ(flowX1.size(), flowXRef.size());
+  EXPECT_EQ(cv::norm(flowX1, flowXRef, cv::NORM_INF), 0);
+  EXPECT_EQ(cv::norm(flowY1, flowYRef, cv::NORM_INF), 0);
+
+  // only the windows inside the images are registered
+  uint64_t insideWindows = 0;
+  for (int r = 0; r < flowX1.rows; ++r)
+    for (int c = 0; c < flowX1.cols; ++c)
+    {
+      const cv::Point2i center(c / resolution, r / resolution);
+      insideWindows += center.x - ipc.GetCols() / 2 >= 0 and center.y - ipc.GetRows() / 2 >= 0 and center.x + ipc.GetCols() / 2 < image1.cols and
+                       center.y + ipc.GetRows() / 2 < image1.rows;
+    }
+  EXPECT_EQ(scope.Get().adaptiveRegistrations, insideWindows);
+  EXPECT_EQ(scope.Get().adaptivePixels, flowX1.total());
+
+  // smooth flow is interpolated from the coarse grid
+  const auto [flowX, flowY] = IPCFlow::CalculateFlowAdaptive(ipc, image1, image2, resolution, 8, 0.25);
+  EXPECT_LE(cv::norm(flowX, flowXRef, cv::NORM_INF), 0.5);
+  EXPECT_LE(cv::norm(flowY, flowYRef, cv::NORM_INF), 0.5);
+  EXPECT_LE(cv::norm(flowX, flowXRef, cv::NORM_L1) / flowX.total(), 0.05);
+  EXPECT_LE(cv::norm(flowY, flowYRef, cv::NORM_L1) / flowY.total(), 0.05);
+  EXPECT_LT(scope.Get().adaptiveRegistrations - insideWindows, insideWindows);
+
+  // motion discontinuities are refined, the flow of the windows on either side follows its motion
+  cv::Mat image2Split = image2.clone(), image2Right = image2Split.colRange(80, 160);
+  RoiCrop(shiftedRight, 500, 500, 160, 120).colRange(80, 160).copyTo(image2Right);
+  const auto [flowXSplit, flowYSplit] = IPCFlow::CalculateFlowAdaptive(ipc, image1, image2Split, resolution, 8, 0.25);
+  for (int r = 0; r < flowXSplit.rows; ++r)
+    for (int c = 0; c < flowXSplit.cols; ++c)
+    {
+      const cv::Point2i center(c / resolution, r / resolution);
+      const bool inside = center.x - ipc.GetCols() / 2 >= 0 and center.y - ipc.GetRows() / 2 >= 0 and center.x + ipc.GetCols() / 2 < image1.cols and
+                          center.y + ipc.GetRows() / 2 < image1.rows;
+      if (not inside or (center.x + ipc.GetCols() / 2 >= 80 and center.x - ipc.GetCols() / 2 < 80))
+        continue;
+
+      const auto& shift = center.x < 80 ? shiftLeft : shiftRight;
+      EXPECT_NEAR(flowXSplit.at<IPC::Float>(r, c), shift.x, 0.5);
+      EXPECT_NEAR(flowYSplit.at<IPC::Float>(r, c), shift.y, 0.5);
+    }
+
+  EXPECT_THROW(IPCFlow::CalculateFlowAdaptive(ipc, image1, image2, resolution, 0), std::invalid_argument);
+}
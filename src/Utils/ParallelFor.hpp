@@ -0,0 +1,37 @@
+#pragma once
+
+// run func(idx) for all idx in [0, count) in parallel with a dynamic schedule, exceptions cannot leave the parallel region so the first one is
+// rethrown after all iterations finished
+template <typename Func>
+void ParallelFor(int count, Func&& func)
+{
+  std::exception_ptr exception;
+
+#pragma omp parallel for schedule(dynamic)
+  for (int idx = 0; idx < count; ++idx)
+    try
+    {
+      func(idx);
+    }
+    catch (...)
+    {
+#pragma omp critical
+      if (not exception)
+        exception = std::current_exception();
+    }
+
+  if (exception) [[unlikely]]
+    std::rethrow_exception(exception);
+}
+
+// calculate(items1[idx], items2[idx]) for all pairs of the equally sized spans in parallel, the results are in pair order
+template <typename Item, typename Func>
+auto ParallelForPairs(std::span<const Item> items1, std::span<const Item> items2, Func&& calculate)
+{
+  if (items1.size() != items2.size()) [[unlikely]]
+    throw std::invalid_argument(fmt::format("Pair counts differ ({} != {})", items1.size(), items2.size()));
+
+  std::vector<std::invoke_result_t<Func&, const Item&, const Item&>> results(items1.size());
+  ParallelFor(static_cast<int>(results.size()), [&](int idx) { results[idx] = calculate(items1[idx], items2[idx]); });
+  return results;
+}